@@ -162,22 +162,20 @@ void setup()
 		tlSensors.initialize(n, TLSampleMethodCVD);
 
 		/* Set pin to an invalid setting */
-		tlSensors.data[n].tlStructSampleMethod.CVD.pin = -1;
-		tlSensors.data[n].pin =
-			&(tlSensors.data[n].tlStructSampleMethod.CVD.pin);
+		tlSensors.config(n).tlStructSampleMethod.CVD.pin = -1;
 
 		/*
 		 * Disable state machine so we can control updating average in
 		 * the main loop.
 		 */
-		tlSensors.data[n].enableTouchStateMachine = false;
+		tlSensors.config(n).enableTouchStateMachine = false;
 
-		tlSensors.data[n].disableUpdateIfAnyButtonIsApproached = false;
-		tlSensors.data[n].disableUpdateIfAnyButtonIsPressed = false;
+		tlSensors.config(n).disableUpdateIfAnyButtonIsApproached = false;
+		tlSensors.config(n).disableUpdateIfAnyButtonIsPressed = false;
 		/* Enable noise power measurement */
-		tlSensors.data[n].enableNoisePowerMeasurement = true;
+		tlSensors.config(n).enableNoisePowerMeasurement = true;
 
-		tlSensors.data[n].forceCalibrationWhenApproachingFromPressed = 0UL;
+		tlSensors.forceCalibrationWhenApproachingFromPressed[n].clearAll();
 	}
 
 	if (tlSensors.error) {
@@ -529,7 +527,7 @@ bool askPower(int timeout)
 
 	for (n = 0; n < nSensors; n++) {
 		if (ret) {
-			tlSensors.data[n].filterType =
+			tlSensors.config(n).filterType =
 				TLStruct::filterTypeSlewrateLimiter;
 		}
 	}
@@ -541,8 +539,8 @@ void askPinning(int n)
 {
 	int pin = 0;
 
-	if ((tlSensors.data[n].sampleMethod == TLSampleMethodCVD) ||
-		(tlSensors.data[n].sampleMethod == TLSampleMethodResistive)) {
+	if ((tlSensors.config(n).sampleMethod == TLSampleMethodCVD) ||
+		(tlSensors.config(n).sampleMethod == TLSampleMethodResistive)) {
 		do {
 			Serial.print(F("Which analog pin is sensor "));
 			Serial.print(n);
@@ -555,7 +553,7 @@ void askPinning(int n)
 			}
 		} while (pin == -1);
 	}
-	if (tlSensors.data[n].sampleMethod == TLSampleMethodTouchRead) {
+	if (tlSensors.config(n).sampleMethod == TLSampleMethodTouchRead) {
 		#if IS_TEENSY3X_WITH_TOUCHREAD
 		do {
 			Serial.print(F("Which touch pin is sensor "));
@@ -582,19 +580,19 @@ void askPinning(int n)
 		#endif
 	}
 
-	if (tlSensors.data[n].sampleMethod == TLSampleMethodCVD) {
-		tlSensors.data[n].tlStructSampleMethod.CVD.pin = pin;
+	if (tlSensors.config(n).sampleMethod == TLSampleMethodCVD) {
+		tlSensors.config(n).tlStructSampleMethod.CVD.pin = pin;
 	}
 
-	if (tlSensors.data[n].sampleMethod == TLSampleMethodTouchRead) {
-		tlSensors.data[n].tlStructSampleMethod.touchRead.pin = pin;
+	if (tlSensors.config(n).sampleMethod == TLSampleMethodTouchRead) {
+		tlSensors.config(n).tlStructSampleMethod.touchRead.pin = pin;
 	}
 
-	if (tlSensors.data[n].sampleMethod == TLSampleMethodResistive) {
-		tlSensors.data[n].tlStructSampleMethod.resistive.pin = pin;
+	if (tlSensors.config(n).sampleMethod == TLSampleMethodResistive) {
+		tlSensors.config(n).tlStructSampleMethod.resistive.pin = pin;
 	}
 
-	if (tlSensors.data[n].sampleMethod == TLSampleMethodResistive) {
+	if (tlSensors.config(n).sampleMethod == TLSampleMethodResistive) {
 		do {
 			Serial.print(F("Which digital pin is the resistive "
 				" sensor also connected to (used as ground "
@@ -606,7 +604,7 @@ void askPinning(int n)
 			}
 		} while (pin == -1);
 
-		tlSensors.data[n].tlStructSampleMethod.resistive.gndPin = pin;
+		tlSensors.config(n).tlStructSampleMethod.resistive.gndPin = pin;
 	}
 }
 
@@ -644,7 +642,7 @@ bool askSampleMethod(int n)
 			}
 			if (lower(c) == 'r') {
 				tlSensors.initialize(n, TLSampleMethodResistive);
-				tlSensors.data[n].filterType =
+				tlSensors.config(n).filterType =
 					TLStruct::filterTypeAverage;
 			}
 			break;
@@ -679,7 +677,7 @@ bool askSampleMethod(int n)
 			}
 			if (lower(c) == 'r') {
 				tlSensors.initialize(n, TLSampleMethodResistive);
-				tlSensors.data[n].filterType =
+				tlSensors.config(n).filterType =
 					TLStruct::filterTypeAverage;
 			}
 			break;
@@ -713,8 +711,8 @@ void noiseTuning(void)
 
 	Serial.println(F("Noise measurement started... "));
 	for (n = 0; n < nSensors; n++) {
-		tlSensors.data[n].enableTouchStateMachine = false;
-		tlSensors.data[n].enableNoisePowerMeasurement = true;
+		tlSensors.config(n).enableTouchStateMachine = false;
+		tlSensors.config(n).enableNoisePowerMeasurement = true;
 		tlSensors.setState(n, TLStruct::buttonStatePreCalibrating);
 	}
 	while (tlSensors.getState(0) != TLStruct::buttonStateReleased) {
@@ -731,17 +729,17 @@ void noiseTuning(void)
 		 * very reliable.
 		 */
 		#if (1)
-		if (tlSensors.data[n].releasedToApproachedThreshold <
+		if (tlSensors.config(n).releasedToApproachedThreshold <
 				3 * sqrt(tlSensors.data[n].noisePower)) {
-			tlSensors.data[n].releasedToApproachedThreshold =
+			tlSensors.config(n).releasedToApproachedThreshold =
 				3 * sqrt(tlSensors.data[n].noisePower);
 			highNoise = true;
 		}
 	
-		if (tlSensors.data[n].approachedToReleasedThreshold <
+		if (tlSensors.config(n).approachedToReleasedThreshold <
 				(9 * 3 * sqrt(tlSensors.data[n].noisePower) +
 				5) / 10) {
-			tlSensors.data[n].approachedToReleasedThreshold =
+			tlSensors.config(n).approachedToReleasedThreshold =
 				(9 * 3 * sqrt(tlSensors.data[n].noisePower) +
 				5) / 10;
 			highNoise = true;
@@ -760,9 +758,9 @@ void noiseTuning(void)
 		}*/
 	
 		Serial.print(F("    released -> approached: "));
-		Serial.println(tlSensors.data[n].releasedToApproachedThreshold);
+		Serial.println(tlSensors.config(n).releasedToApproachedThreshold);
 		Serial.print(F("    approached -> released: "));
-		Serial.println(tlSensors.data[n].approachedToReleasedThreshold);
+		Serial.println(tlSensors.config(n).approachedToReleasedThreshold);
 		Serial.println("");
 	}
 
@@ -781,13 +779,13 @@ bool touchTuning(int n)
 	bool isTuned = false;
 
 	Serial.print(F("Performing touch measurement for "));
-	if (tlSensors.data[n].sampleMethod == TLSampleMethodCVD) {
+	if (tlSensors.config(n).sampleMethod == TLSampleMethodCVD) {
 		Serial.print(F("capacitive (CVD method)"));
 	}
-	if (tlSensors.data[n].sampleMethod == TLSampleMethodTouchRead) {
+	if (tlSensors.config(n).sampleMethod == TLSampleMethodTouchRead) {
 		Serial.print(F("capacitive (touchRead() method)"));
 	}
-	if (tlSensors.data[n].sampleMethod == TLSampleMethodResistive) {
+	if (tlSensors.config(n).sampleMethod == TLSampleMethodResistive) {
 		Serial.print(F("resistive (analogRead() method)"));
 	}
 	Serial.print(F(" sensor "));
@@ -814,7 +812,7 @@ bool touchTuning(int n)
 			break;
 		}
 	
-		tlSensors.data[n].enableTouchStateMachine = false;
+		tlSensors.config(n).enableTouchStateMachine = false;
 		tlSensors.setState(n, TLStruct::buttonStatePressed);
 	
 		for (k = 0; k < N_MEASUREMENTS; k++) {
@@ -830,18 +828,18 @@ bool touchTuning(int n)
 		}
 		avg = avg / N_MEASUREMENTS;
 		
-		tlSensors.data[n].approachedToPressedThreshold = (avg >> 1);
-		tlSensors.data[n].pressedToApproachedThreshold = (9 *
-			tlSensors.data[n].approachedToPressedThreshold + 5) / 10;
+		tlSensors.config(n).approachedToPressedThreshold = (avg >> 1);
+		tlSensors.config(n).pressedToApproachedThreshold = (9 *
+			tlSensors.config(n).approachedToPressedThreshold + 5) / 10;
 
-		if (tlSensors.data[n].pressedToApproachedThreshold < ((11 *
-				tlSensors.data[n].releasedToApproachedThreshold
+		if (tlSensors.config(n).pressedToApproachedThreshold < ((11 *
+				tlSensors.config(n).releasedToApproachedThreshold
 				+ 5) / 10)) {
 			Serial.print(F("Error! Detected signal is too low: "));
-			Serial.print(tlSensors.data[n].pressedToApproachedThreshold);
+			Serial.print(tlSensors.config(n).pressedToApproachedThreshold);
 			Serial.print(F(" < "));
 			Serial.print((11 *
-				tlSensors.data[n].releasedToApproachedThreshold
+				tlSensors.config(n).releasedToApproachedThreshold
 				+ 5) / 10);
 			Serial.print(". ");
 		} else {
@@ -854,20 +852,20 @@ bool touchTuning(int n)
 	if (isTuned) {
 		Serial.println(F("Found the following thresholds:"));
 		Serial.print(F("  approached -> pressed: "));
-		Serial.println(tlSensors.data[n].approachedToPressedThreshold);
+		Serial.println(tlSensors.config(n).approachedToPressedThreshold);
 		Serial.print(F("  pressed -> approached: "));
-		Serial.println(tlSensors.data[n].pressedToApproachedThreshold);
+		Serial.println(tlSensors.config(n).pressedToApproachedThreshold);
 	} else {
 		/* 
 		 * Skip tuning for this sensor; instead set some sensible
 		 * defaults
 		 */
-		tlSensors.data[n].approachedToPressedThreshold =
-			tlSensors.data[n].releasedToApproachedThreshold * 10;
-		tlSensors.data[n].pressedToApproachedThreshold = (9 *
-			tlSensors.data[n].approachedToPressedThreshold + 5) / 10;
-		tlSensors.data[n].calibratedMaxDelta = (11 *
-			tlSensors.data[n].approachedToPressedThreshold + 5) / 10;
+		tlSensors.config(n).approachedToPressedThreshold =
+			tlSensors.config(n).releasedToApproachedThreshold * 10;
+		tlSensors.config(n).pressedToApproachedThreshold = (9 *
+			tlSensors.config(n).approachedToPressedThreshold + 5) / 10;
+		tlSensors.config(n).calibratedMaxDelta = (11 *
+			tlSensors.config(n).approachedToPressedThreshold + 5) / 10;
 		Serial.print(F("\nSkipped tuning sensor "));
 		Serial.print(n);
 	}
@@ -885,13 +883,13 @@ void maxTouchTuning(int n)
 	bool done = false;
 
 	Serial.print(F("Performing maximum range measurement for "));
-	if (tlSensors.data[n].sampleMethod == TLSampleMethodCVD) {
+	if (tlSensors.config(n).sampleMethod == TLSampleMethodCVD) {
 		Serial.print(F("capacitive (CVD method)"));
 	}
-	if (tlSensors.data[n].sampleMethod == TLSampleMethodTouchRead) {
+	if (tlSensors.config(n).sampleMethod == TLSampleMethodTouchRead) {
 		Serial.print(F("capacitive (touchRead() method)"));
 	}
-	if (tlSensors.data[n].sampleMethod == TLSampleMethodResistive) {
+	if (tlSensors.config(n).sampleMethod == TLSampleMethodResistive) {
 		Serial.print(F("resistive (analogRead() method)"));
 	}
 	Serial.print(F(" sensor "));
@@ -900,7 +898,7 @@ void maxTouchTuning(int n)
 
 	do {
 		do {
-			if (tlSensors.data[n].sampleMethod == 
+			if (tlSensors.config(n).sampleMethod == 
 					TLSampleMethodCVD) {
 				Serial.print(F("Make sure to cover and hold "
 					"the sensor with as many fingers as "
@@ -908,7 +906,7 @@ void maxTouchTuning(int n)
 					" press y to start the touch "
 					"measurement. "));
 			}
-			if (tlSensors.data[n].sampleMethod == 
+			if (tlSensors.config(n).sampleMethod == 
 					TLSampleMethodResistive) {
 				Serial.print(F("Make sure to press and hold the"
 					"sensor as firmly as possible, then\n"
@@ -923,7 +921,7 @@ void maxTouchTuning(int n)
 			}
 		} while (lower(c) != 'y');
 	
-		tlSensors.data[n].enableTouchStateMachine = false;
+		tlSensors.config(n).enableTouchStateMachine = false;
 		tlSensors.setState(n, TLStruct::buttonStatePressed);
 	
 		for (k = 0; k < N_MEASUREMENTS; k++) {
@@ -944,11 +942,11 @@ void maxTouchTuning(int n)
 		 */
 
 		if (maxDelta[N_MEASUREMENTS - 1] < 
-				tlSensors.data[n].approachedToPressedThreshold) {
-			tlSensors.data[n].calibratedMaxDelta = 
-				tlSensors.data[n].approachedToPressedThreshold;
+				tlSensors.config(n).approachedToPressedThreshold) {
+			tlSensors.config(n).calibratedMaxDelta = 
+				tlSensors.config(n).approachedToPressedThreshold;
 		} else {
-			tlSensors.data[n].calibratedMaxDelta =
+			tlSensors.config(n).calibratedMaxDelta =
 				maxDelta[N_MEASUREMENTS - 1];
 		}
 
@@ -968,7 +966,7 @@ int countNSensors(int (*sampleMethod)(struct TLStruct * d, uint8_t nSensors,
 	k = 0;
 
 	for (n = 0; n < nSensors; n++) {
-		if (tlSensors.data[n].sampleMethod == sampleMethod) {
+		if (tlSensors.config(n).sampleMethod == sampleMethod) {
 			k++;
 		}
 	}
@@ -985,25 +983,25 @@ void checkResistiveCapacitiveSensor(int n)
 	k = tlSensors.findSensorPair(n, (n + 1) % nSensors);
 
 	if (k >= 0) {
-		if (tlSensors.data[k].sampleMethod == TLSampleMethodResistive) {
+		if (tlSensors.config(k).sampleMethod == TLSampleMethodResistive) {
 			res_sensor = k;
-			res_pin = tlSensors.data[k].tlStructSampleMethod.resistive.pin;
+			res_pin = tlSensors.config(k).tlStructSampleMethod.resistive.pin;
 		}
 
-		if (tlSensors.data[k].sampleMethod == TLSampleMethodCVD) {
+		if (tlSensors.config(k).sampleMethod == TLSampleMethodCVD) {
 			cap_sensor = k;
-			cap_pin = tlSensors.data[k].tlStructSampleMethod.CVD.pin;
+			cap_pin = tlSensors.config(k).tlStructSampleMethod.CVD.pin;
 		}
 	}
 
-	if (tlSensors.data[n].sampleMethod == TLSampleMethodResistive) {
+	if (tlSensors.config(n).sampleMethod == TLSampleMethodResistive) {
 		res_sensor = n;
-		res_pin = tlSensors.data[n].tlStructSampleMethod.resistive.pin;
+		res_pin = tlSensors.config(n).tlStructSampleMethod.resistive.pin;
 	}
 
-	if (tlSensors.data[n].sampleMethod == TLSampleMethodCVD) {
+	if (tlSensors.config(n).sampleMethod == TLSampleMethodCVD) {
 		cap_sensor = n;
-		cap_pin = tlSensors.data[n].tlStructSampleMethod.CVD.pin;
+		cap_pin = tlSensors.config(n).tlStructSampleMethod.CVD.pin;
 	}
 
 	if (res_pin == cap_pin) {
@@ -1015,8 +1013,8 @@ void checkResistiveCapacitiveSensor(int n)
 			"that the resistive sensor is automatically "
 			"recalibrated when the capacitive sensor is released."));
 
-		tlSensors.data[cap_sensor].forceCalibrationWhenApproachingFromPressed |=
-	                (1UL << res_sensor);
+		tlSensors.forceCalibrationWhenApproachingFromPressed[cap_sensor].set(
+			res_sensor);
 	}
 }
 
@@ -1028,7 +1026,7 @@ void printCode(void)
 	 */
 
 	char c;
-	int n, pin;
+	int n, k, pin;
 
 	do {
 		Serial.print(F("Tuning has finished. Press y to get copy/paste "
@@ -1055,23 +1053,23 @@ void printCode(void)
 		Serial.print(F(" *   sensor "));
 		Serial.print(n);
 		Serial.print(F(": type: "));
-		if (tlSensors.data[n].sampleMethod == TLSampleMethodCVD) {
+		if (tlSensors.config(n).sampleMethod == TLSampleMethodCVD) {
 			Serial.print(F("capacitive (CVD method), analog pin A"));
-			pin = tlSensors.data[n].tlStructSampleMethod.CVD.pin;
+			pin = tlSensors.config(n).tlStructSampleMethod.CVD.pin;
 			Serial.print(pin - A0);
 		}
-		if (tlSensors.data[n].sampleMethod == TLSampleMethodTouchRead) {
+		if (tlSensors.config(n).sampleMethod == TLSampleMethodTouchRead) {
 			Serial.print(F("capacitive (touchRead()) method), pin "));
-			pin = tlSensors.data[n].tlStructSampleMethod.touchRead.pin;
+			pin = tlSensors.config(n).tlStructSampleMethod.touchRead.pin;
 			Serial.print(pin);
 		}
-		if (tlSensors.data[n].sampleMethod == TLSampleMethodResistive) {
+		if (tlSensors.config(n).sampleMethod == TLSampleMethodResistive) {
 			Serial.print(F("resistive (analogRead() method),  "
 				"analog pin A"));
-			pin = tlSensors.data[n].tlStructSampleMethod.resistive.pin;
+			pin = tlSensors.config(n).tlStructSampleMethod.resistive.pin;
 			Serial.print(pin - A0);
 			Serial.print(F(", ground pin: "));
-			Serial.print(tlSensors.data[n].tlStructSampleMethod.resistive.gndPin);
+			Serial.print(tlSensors.config(n).tlStructSampleMethod.resistive.gndPin);
 		}
 		Serial.print(F("\n"));
 	}
@@ -1193,106 +1191,106 @@ void printCode(void)
 		Serial.print(F("         * Configuration for sensor "));
 		Serial.print(n);
 		Serial.print(F(":\n"));
-		if (tlSensors.data[n].sampleMethod == TLSampleMethodCVD) {
+		if (tlSensors.config(n).sampleMethod == TLSampleMethodCVD) {
 			Serial.print(F("         * Type: capacitive (CVD "
 				"method)\n"));
 			Serial.print(F("         * Analog pin: A"));
-			pin = tlSensors.data[n].tlStructSampleMethod.CVD.pin;
+			pin = tlSensors.config(n).tlStructSampleMethod.CVD.pin;
 			Serial.print(pin - A0);
 		}
-		if (tlSensors.data[n].sampleMethod == TLSampleMethodTouchRead) {
+		if (tlSensors.config(n).sampleMethod == TLSampleMethodTouchRead) {
 			Serial.print(F("         * Type: capacitive "
 				"(touchRead() method)\n"));
 			Serial.print(F("         * Pin: "));
-			pin = tlSensors.data[n].tlStructSampleMethod.touchRead.pin;
+			pin = tlSensors.config(n).tlStructSampleMethod.touchRead.pin;
 			Serial.print(pin);
 		}
-		if (tlSensors.data[n].sampleMethod == TLSampleMethodResistive) {
+		if (tlSensors.config(n).sampleMethod == TLSampleMethodResistive) {
 			Serial.print(F("         * Type: resistive "
 				"(analogRead() method)\n"));
 			Serial.print(F("         * Analog pin: A"));
-			pin = tlSensors.data[n].tlStructSampleMethod.resistive.pin;
+			pin = tlSensors.config(n).tlStructSampleMethod.resistive.pin;
 			Serial.print(pin - A0);
 		}
 		Serial.print(F("\n"));
-		if (tlSensors.data[n].sampleMethod == TLSampleMethodResistive) {
+		if (tlSensors.config(n).sampleMethod == TLSampleMethodResistive) {
 			Serial.print(F("         * Ground pin: "));
-			Serial.print(tlSensors.data[n].tlStructSampleMethod.resistive.gndPin);
+			Serial.print(tlSensors.config(n).tlStructSampleMethod.resistive.gndPin);
 			Serial.print(F("\n"));
 		}
 		Serial.print(F("         */\n"));
 		Serial.print(F("        tlSensors.initialize("));
 		Serial.print(n);
-		if (tlSensors.data[n].sampleMethod == TLSampleMethodCVD) {
+		if (tlSensors.config(n).sampleMethod == TLSampleMethodCVD) {
 			Serial.print(F(", TLSampleMethodCVD);\n"));
 		}
-		if (tlSensors.data[n].sampleMethod == TLSampleMethodTouchRead) {
+		if (tlSensors.config(n).sampleMethod == TLSampleMethodTouchRead) {
 			Serial.print(F(", TLSampleMethodTouchRead);\n"));
 		}
-		if (tlSensors.data[n].sampleMethod == TLSampleMethodResistive) {
+		if (tlSensors.config(n).sampleMethod == TLSampleMethodResistive) {
 			Serial.print(F(", TLSampleMethodResistive);\n"));
 		}
-		Serial.print(F("        tlSensors.data["));
+		Serial.print(F("        tlSensors.config("));
 		Serial.print(n);
-		Serial.print(F("].tlStructSampleMethod."));
-		if (tlSensors.data[n].sampleMethod == TLSampleMethodCVD) {
+		Serial.print(F(").tlStructSampleMethod."));
+		if (tlSensors.config(n).sampleMethod == TLSampleMethodCVD) {
 			Serial.print(F("CVD.pin =               A"));
-			pin = tlSensors.data[n].tlStructSampleMethod.CVD.pin;
+			pin = tlSensors.config(n).tlStructSampleMethod.CVD.pin;
 			Serial.print(pin - A0);
 		}
-		if (tlSensors.data[n].sampleMethod == TLSampleMethodTouchRead) {
+		if (tlSensors.config(n).sampleMethod == TLSampleMethodTouchRead) {
 			Serial.print(F("touchRead.pin =         "));
-			pin = tlSensors.data[n].tlStructSampleMethod.touchRead.pin;
+			pin = tlSensors.config(n).tlStructSampleMethod.touchRead.pin;
 			Serial.print(pin);
 		}
-		if (tlSensors.data[n].sampleMethod == TLSampleMethodResistive) {
+		if (tlSensors.config(n).sampleMethod == TLSampleMethodResistive) {
 			Serial.print(F("resistive.pin =         A"));
-			pin = tlSensors.data[n].tlStructSampleMethod.resistive.pin;
+			pin = tlSensors.config(n).tlStructSampleMethod.resistive.pin;
 			Serial.print(pin - A0);
 		}
 		Serial.print(F(";\n"));
-		if (tlSensors.data[n].sampleMethod == TLSampleMethodResistive) {
-			Serial.print(F("        tlSensors.data["));
+		if (tlSensors.config(n).sampleMethod == TLSampleMethodResistive) {
+			Serial.print(F("        tlSensors.config("));
 			Serial.print(n);
-			Serial.print(F("].tlStructSampleMethod.resistive.gndPin"
+			Serial.print(F(").tlStructSampleMethod.resistive.gndPin"
 				" =      "));
-			Serial.print(tlSensors.data[n].tlStructSampleMethod.resistive.gndPin);
+			Serial.print(tlSensors.config(n).tlStructSampleMethod.resistive.gndPin);
 			Serial.print(F(";\n"));
 		}
-		Serial.print(F("        tlSensors.data["));
+		Serial.print(F("        tlSensors.config("));
 		Serial.print(n);
-		Serial.print(F("].releasedToApproachedThreshold ="
+		Serial.print(F(").releasedToApproachedThreshold ="
 			"              "));
-		Serial.print(tlSensors.data[n].releasedToApproachedThreshold);
+		Serial.print(tlSensors.config(n).releasedToApproachedThreshold);
 		Serial.print(F(";\n"));
-		Serial.print(F("        tlSensors.data["));
+		Serial.print(F("        tlSensors.config("));
 		Serial.print(n);
-		Serial.print(F("].approachedToReleasedThreshold ="
+		Serial.print(F(").approachedToReleasedThreshold ="
 			"              "));
-		Serial.print(tlSensors.data[n].approachedToReleasedThreshold);
+		Serial.print(tlSensors.config(n).approachedToReleasedThreshold);
 		Serial.print(F(";\n"));
-		Serial.print(F("        tlSensors.data["));
+		Serial.print(F("        tlSensors.config("));
 		Serial.print(n);
-		Serial.print(F("].approachedToPressedThreshold ="
+		Serial.print(F(").approachedToPressedThreshold ="
 			"               "));
-		Serial.print(tlSensors.data[n].approachedToPressedThreshold);
+		Serial.print(tlSensors.config(n).approachedToPressedThreshold);
 		Serial.print(F(";\n"));
-		Serial.print(F("        tlSensors.data["));
+		Serial.print(F("        tlSensors.config("));
 		Serial.print(n);
-		Serial.print(F("].pressedToApproachedThreshold ="
+		Serial.print(F(").pressedToApproachedThreshold ="
 			"               "));
-		Serial.print(tlSensors.data[n].pressedToApproachedThreshold);
+		Serial.print(tlSensors.config(n).pressedToApproachedThreshold);
 		Serial.print(F(";\n"));
-		Serial.print(F("        tlSensors.data["));
+		Serial.print(F("        tlSensors.config("));
 		Serial.print(n);
-		Serial.print(F("].calibratedMaxDelta ="
+		Serial.print(F(").calibratedMaxDelta ="
 			"                         "));
-		Serial.print(tlSensors.data[n].calibratedMaxDelta);
+		Serial.print(tlSensors.config(n).calibratedMaxDelta);
 		Serial.print(F(";\n"));
-		Serial.print(F("        tlSensors.data["));
+		Serial.print(F("        tlSensors.config("));
 		Serial.print(n);
-		Serial.print(F("].filterType = TLStruct::filterType"));
-		switch (tlSensors.data[n].filterType) {
+		Serial.print(F(").filterType = TLStruct::filterType"));
+		switch (tlSensors.config(n).filterType) {
 		case TLStruct::filterTypeAverage:
 			Serial.print(F("Average;\n"));
 			break;
@@ -1302,20 +1300,42 @@ void printCode(void)
 		case TLStruct::filterTypeMedian:
 			Serial.print(F("Median;\n"));
 			break;
+		case TLStruct::filterTypeMedian3:
+			Serial.print(F("Median3;\n"));
+			break;
+		case TLStruct::filterTypeTrimmedMean:
+			Serial.print(F("TrimmedMean;\n"));
+			Serial.print(F("        tlSensors.config("));
+			Serial.print(n);
+			Serial.print(F(").filterTrim ="
+				"                                 "));
+			Serial.print(tlSensors.config(n).filterTrim);
+			Serial.print(F(";\n"));
+			break;
+		case TLStruct::filterTypeIIR:
+			Serial.print(F("IIR;\n"));
+			Serial.print(F("        tlSensors.config("));
+			Serial.print(n);
+			Serial.print(F(").filterIIRShift ="
+				"                             "));
+			Serial.print(tlSensors.config(n).filterIIRShift);
+			Serial.print(F(";\n"));
+			break;
 		default:
 			/* Error? */
 			Serial.print(F("Average;\n"));
 			break;
 		}
 
-		if (tlSensors.data[n].forceCalibrationWhenApproachingFromPressed) {
-			Serial.print(F("        tlSensors.data["));
+		for (k = tlSensors.forceCalibrationWhenApproachingFromPressed[n].first();
+				k >= 0; k =
+				tlSensors.forceCalibrationWhenApproachingFromPressed[n].next(k)) {
+			Serial.print(F("        tlSensors."
+				"forceCalibrationWhenApproachingFromPressed["));
 			Serial.print(n);
-			Serial.print(F("].forceCalibrationWhenApproachingFromPressed"
-				" = 0x"));
-			Serial.print(tlSensors.data[n].forceCalibrationWhenApproachingFromPressed,
-				HEX);
-			Serial.print(F(";\n"));
+			Serial.print(F(").set("));
+			Serial.print(k);
+			Serial.print(F(");\n"));
 		}
 	}
 
@@ -1456,7 +1476,7 @@ void loop()
 		Serial.print("sensor ");
 		Serial.print(n);
 		Serial.print(": CVD pin: ");
-		Serial.println(tlSensors.data[n].tlStructSampleMethod.CVD.pin);
+		Serial.println(tlSensors.config(n).tlStructSampleMethod.CVD.pin);
 	}
 
 	n = countNSensors(TLSampleMethodCVD);
@@ -1478,7 +1498,7 @@ void loop()
 		Serial.print("sensor ");
 		Serial.print(n);
 		Serial.print(": CVD pin: ");
-		Serial.println(tlSensors.data[n].tlStructSampleMethod.CVD.pin);
+		Serial.println(tlSensors.config(n).tlStructSampleMethod.CVD.pin);
 	}
 	
 	for (n = 0; n < nSensors; n++) {
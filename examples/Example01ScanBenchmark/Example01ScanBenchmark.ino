@@ -0,0 +1,275 @@
+#include <TouchLib.h>
+
+/*
+ * Touch Library scan throughput benchmark
+ *
+ * Measures how long TLSensors::sample() takes for several combinations of
+ * number of sensors and number of measurements per sensor. For every
+ * combination it reports:
+ * - scans / second
+ * - average time per scan order position (a single measurement of 1 sensor)
+ * - time per scan spent in the pre-sample stage (resetting filters and
+ *   sampleMethodPreSample()), the sample stage (all scan order positions), the
+ *   post-sample stage (sampleMethodPostSample()) and processSample() (state
+ *   machine and button state summaries)
+ * - RAM used by the TLSensors object in bytes (sizeof), which includes the
+ *   per sensor TLStruct and the filter and scan buffers
+ *
+ * All times are in nanoseconds (ns) per scan, except for the time per
+ * position which is the average time of a single measurement.
+ *
+ * The last rows compare the filter types (TLStruct::filterType) with the CVD
+ * method. The filter runs for every measurement, so its cost shows up in the
+ * time per position.
+ *
+ * The benchmark runs on any supported board, but also on a PC with the host
+ * backend (see TLHost.h), which simulates the electrodes. To build and run it
+ * on Linux:
+ *
+ *   g++ -O2 -DTL_HOST -Isrc -x c++ \
+ *     examples/Example01ScanBenchmark/Example01ScanBenchmark.ino \
+ *     -x none src/TL*.cpp -o scanbenchmark && ./scanbenchmark
+ *
+ * Note that on the host the sample stage mainly measures the overhead of the
+ * library, since simulated ADC conversions take almost no time.
+ */
+
+/* Number of scans to perform after calibration has finished */
+#define N_SCANS				100
+
+/* Largest number of sensors used in any of the benchmarks below */
+#define N_SENSORS_MAX			32
+
+static unsigned long tSequenceStarted;
+static unsigned long tPositionStarted;
+static unsigned long tPostSampleFinished;
+static unsigned long tPreSample;
+static unsigned long tSample;
+static unsigned long tPostSample;
+static unsigned long tProcessSample;
+static unsigned long nPositions;
+static bool postSampleStarted;
+
+static int (*postSample[N_SENSORS_MAX])(struct TLStruct * d, uint8_t nSensors,
+	uint8_t ch);
+
+static void sequenceMeasurementProgress(bool isStarted)
+{
+	unsigned long now = micros();
+
+	if (isStarted) {
+		tSequenceStarted = now;
+		postSampleStarted = false;
+	} else if (postSampleStarted) {
+		tProcessSample += now - tPostSampleFinished;
+	}
+}
+
+static void buttonMeasurementProgress(uint16_t idx, uint8_t ch,
+	bool isStarted)
+{
+	unsigned long now = micros();
+
+	if (isStarted) {
+		if (idx == 0) {
+			tPreSample += now - tSequenceStarted;
+		}
+		tPositionStarted = now;
+	} else {
+		tSample += now - tPositionStarted;
+		nPositions++;
+	}
+}
+
+/*
+ * Wrapper around the sampleMethodPostSample() callback of the sample method.
+ * Time between two post-sample calls is spent in processSample().
+ */
+static int timedPostSample(struct TLStruct * d, uint8_t nSensors, uint8_t ch)
+{
+	unsigned long tStart;
+	int ret = 0;
+
+	tStart = micros();
+	if (postSampleStarted) {
+		tProcessSample += tStart - tPostSampleFinished;
+	}
+	postSampleStarted = true;
+
+	if (postSample[ch] != NULL) {
+		ret = postSample[ch](d, nSensors, ch);
+	}
+
+	tPostSampleFinished = micros();
+	tPostSample += tPostSampleFinished - tStart;
+
+	return ret;
+}
+
+static void printPadded(const char * s, int width)
+{
+	int n;
+
+	Serial.print(s);
+	for (n = strlen(s); n < width; n++) {
+		Serial.print(' ');
+	}
+}
+
+static void printPadded(double x, int width)
+{
+	char s[16];
+	int k = sizeof(s) - 1;
+	unsigned long n = (unsigned long) (x + 0.5);
+
+	/* Print as integer; printing floats with fixed width is not portable */
+	s[k] = '\0';
+	do {
+		s[--k] = '0' + (n % 10);
+		n /= 10;
+	} while ((n > 0) && (k > 0));
+	printPadded(&(s[k]), width);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void benchmark(const char * name, int (*sampleMethod)(struct TLStruct * d,
+	uint8_t nSensors, uint8_t ch), enum TLStruct::FilterType filterType =
+	TLStruct::filterTypeAverage)
+{
+	TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR> * tlSensors;
+	unsigned long tStart, tTotal;
+	uint8_t ch;
+	int n;
+
+	/* Allocate on heap so that memory is released after benchmark */
+	tlSensors = new TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>;
+	if (tlSensors == NULL) {
+		Serial.println(F("Out of memory!"));
+		return;
+	}
+
+	for (ch = 0; ch < N_SENSORS; ch++) {
+		tlSensors->initialize(ch, sampleMethod);
+		tlSensors->config(ch).filterType = filterType;
+	}
+
+	/* Wait for calibration to finish */
+	while (tlSensors->anyButtonIsCalibrating()) {
+		tlSensors->sample();
+	}
+
+	for (ch = 0; ch < N_SENSORS; ch++) {
+		postSample[ch] = tlSensors->config(ch).sampleMethodPostSample;
+		tlSensors->config(ch).sampleMethodPostSample = timedPostSample;
+	}
+	tlSensors->sequenceMeasurementProgressCallback =
+		sequenceMeasurementProgress;
+	tlSensors->buttonMeasurementProgressCallback =
+		buttonMeasurementProgress;
+
+	tPreSample = 0;
+	tSample = 0;
+	tPostSample = 0;
+	tProcessSample = 0;
+	nPositions = 0;
+
+	tStart = micros();
+	for (n = 0; n < N_SCANS; n++) {
+		tlSensors->sample();
+	}
+	tTotal = micros() - tStart;
+
+	delete tlSensors;
+
+	if (tTotal == 0) {
+		tTotal = 1;
+	}
+
+	printPadded(name, 12);
+	printPadded(N_SENSORS, 4);
+	printPadded(N_MEASUREMENTS_PER_SENSOR, 4);
+	printPadded(1.0e6 * N_SCANS / tTotal, 10);
+	printPadded(1000.0 * tTotal / N_SCANS, 12);
+	printPadded(1000.0 * tSample / nPositions, 10);
+	printPadded(1000.0 * tPreSample / N_SCANS, 10);
+	printPadded(1000.0 * tSample / N_SCANS, 12);
+	printPadded(1000.0 * tPostSample / N_SCANS, 10);
+	printPadded(1000.0 * tProcessSample / N_SCANS, 10);
+	printPadded(sizeof(TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>),
+		8);
+	Serial.println();
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void benchmarkAllMethods(void)
+{
+	benchmark<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>("CVD",
+		TLSampleMethodCVD);
+	benchmark<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>("Resistive",
+		TLSampleMethodResistive);
+	#if ((IS_TEENSY_WITH_TOUCHREAD) || (IS_ESP32) || (IS_HOST))
+	benchmark<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>("TouchRead",
+		TLSampleMethodTouchRead);
+	#endif
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void benchmarkAllFilterTypes(void)
+{
+	benchmark<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>("CVD Average",
+		TLSampleMethodCVD, TLStruct::filterTypeAverage);
+	benchmark<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>("CVD Slew",
+		TLSampleMethodCVD, TLStruct::filterTypeSlewrateLimiter);
+	#if defined(TL_ENABLE_MEDIAN_FILTER)
+	benchmark<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>("CVD Median",
+		TLSampleMethodCVD, TLStruct::filterTypeMedian);
+	#endif
+	benchmark<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>("CVD IIR",
+		TLSampleMethodCVD, TLStruct::filterTypeIIR);
+	benchmark<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>("CVD Median3",
+		TLSampleMethodCVD, TLStruct::filterTypeMedian3);
+	#if defined(TL_ENABLE_TRIMMED_MEAN_FILTER)
+	benchmark<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>("CVD Trimmed",
+		TLSampleMethodCVD, TLStruct::filterTypeTrimmedMean);
+	#endif
+}
+
+void setup()
+{
+	Serial.begin(9600);
+
+	#if IS_ATMEGA32U4
+	while(!Serial); /* Required for ATmega32u4 processors */
+	#endif
+
+	Serial.println(F("TouchLib scan benchmark. All times in ns."));
+	Serial.print(F("TLStruct: "));
+	Serial.print((int) sizeof(struct TLStruct));
+	Serial.println(F(" bytes per sensor"));
+	Serial.println(F("method      N   M   scans/s   scan        position  "
+		"pre       sample      post      process   RAM"));
+
+	#if IS_ATMEGA16X_32X_32U4
+	/* Limited RAM */
+	benchmarkAllMethods<2, 16>();
+	benchmarkAllMethods<6, 4>();
+	benchmarkAllMethods<6, 16>();
+	#else
+	benchmarkAllMethods<2, 16>();
+	benchmarkAllMethods<8, 16>();
+	benchmarkAllMethods<16, 16>();
+	benchmarkAllMethods<32, 4>();
+	benchmarkAllMethods<32, 16>();
+	#if !(IS_ATMEGA)
+	benchmarkAllMethods<32, 32>();
+	#endif
+	#endif
+
+	benchmarkAllFilterTypes<2, 16>();
+
+	Serial.println(F("Done."));
+}
+
+void loop()
+{
+}
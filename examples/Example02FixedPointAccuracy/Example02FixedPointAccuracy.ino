@@ -0,0 +1,163 @@
+#include <TouchLib.h>
+#include <TLFixedPoint.h>
+#include <math.h>
+
+/* Board specific CVD settings (TL_ADC_MAX, TL_BAR_LOWER_PCT, ...) */
+#if IS_ATMEGA
+#include <TLSampleMethodCVDATMega.h>
+#elif IS_TEENSY3X
+#include <TLSampleMethodCVDTeensy3x.h>
+#elif IS_PARTICLE
+#include <TLSampleMethodCVDParticle.h>
+#elif IS_ESP32
+#include <TLSampleMethodCVDEsp32.h>
+#elif IS_HOST
+#include <TLSampleMethodCVDHost.h>
+#endif
+
+/*
+ * Touch Library fixed point accuracy check
+ *
+ * The CVD sample method converts the raw measurement to a capacitance and
+ * maps deltas to bar lengths with fixed point math (see TLFixedPoint.h). This
+ * sketch compares the results with the same computations in floating point:
+ * - TLLog2Q16() and TLExp2M1Q16() against log2() and pow(2, x) - 1
+ * - value of TLSampleMethodCVDPostSample() for nCharges > 1 against
+ *   referenceValue * scaleFactor / (pow(scale / (scale - raw), 1 / n) - 1),
+ *   for sensor to ADC hold capacitance ratios of 0.25 to 64
+ * - bar length of TLSampleMethodCVDMapDelta() against the same mapping with
+ *   the natural logarithm
+ *
+ * Errors are printed in parts per million (ppm) of the exact value. The
+ * sketch runs on any board, but is quickest on a PC with the host backend
+ * (see TLHost.h):
+ *
+ *   g++ -O2 -DTL_HOST -Isrc -x c++ \
+ *     examples/Example02FixedPointAccuracy/Example02FixedPointAccuracy.ino \
+ *     -x none src/TL*.cpp -o fixedpointaccuracy && ./fixedpointaccuracy
+ */
+
+#define N_MEASUREMENTS_PER_SENSOR	16
+#define BAR_LENGTH			40
+
+TLSensors<2, N_MEASUREMENTS_PER_SENSOR> tlSensors;
+
+static void printResult(const char * name, double err, const char * unit)
+{
+	Serial.print(name);
+	Serial.print((long) (err + 0.5));
+	Serial.println(unit);
+}
+
+static double checkLog2(void)
+{
+	double err, errMax = 0, exact;
+	uint32_t x;
+
+	for (x = 2; x < 0x7FFFFFFFUL; x += (x >> 8) + 1) {
+		exact = log2((double) x);
+		err = fabs(TLLog2Q16(x) / 65536.0 - exact) / exact;
+		errMax = (err > errMax) ? err : errMax;
+	}
+
+	return errMax * 1.0e6;
+}
+
+static double checkExp2M1(void)
+{
+	double err, errMax = 0, exact;
+	uint32_t y;
+
+	/* Results below 0.1 have an absolute error of less than 1 lsb */
+	for (y = 9000; y < (((uint32_t) 15) << 16); y += 7) {
+		exact = pow(2.0, y / 65536.0) - 1;
+		err = fabs(TLExp2M1Q16(y) / 65536.0 - exact) / exact;
+		errMax = (err > errMax) ? err : errMax;
+	}
+
+	return errMax * 1.0e6;
+}
+
+static double checkValue(uint8_t nCharges)
+{
+	struct TLStruct * d = &(tlSensors.data[0]);
+	struct TLStructConfig * c = &(tlSensors.config(0));
+	double err, errMax = 0, exact, scale;
+	int32_t raw;
+
+	scale = 2.0 * N_MEASUREMENTS_PER_SENSOR * (TL_ADC_MAX + 1);
+	c->filterType = TLStruct::filterTypeAverage;
+
+	for (raw = 1; raw < scale; raw++) {
+		d->raw = raw;
+		d->tlStructSampleMethodState.CVD.nCharges = nCharges;
+		TLSampleMethodCVDPostSample(tlSensors.data, 2, 0);
+
+		exact = ((double) c->referenceValue) * c->scaleFactor /
+			(pow(scale / (scale - raw), 1.0 / nCharges) - 1);
+
+		/* Only check realistic range of Cs / Ch (0.25 to 64) */
+		if ((exact < 0.25 * c->referenceValue * c->scaleFactor) ||
+				(exact > 64.0 * c->referenceValue *
+				c->scaleFactor)) {
+			continue;
+		}
+
+		err = fabs(d->value - exact) / exact;
+		errMax = (err > errMax) ? err : errMax;
+	}
+	d->tlStructSampleMethodState.CVD.nCharges = 1;
+
+	return errMax * 1.0e6;
+}
+
+static double checkBar(void)
+{
+	struct TLStruct * d = &(tlSensors.data[0]);
+	struct TLStructConfig * c = &(tlSensors.config(0));
+	long n, exact, errMax = 0;
+	int32_t delta;
+
+	c->calibratedMaxDelta = 1000;
+	for (delta = 1; delta < 4 * c->calibratedMaxDelta; delta++) {
+		d->delta = delta;
+		n = TLSampleMethodCVDMapDelta(tlSensors.data, 2, 0, BAR_LENGTH);
+
+		exact = map(100 * log(delta), TL_BAR_LOWER_PCT *
+			log(c->calibratedMaxDelta), TL_BAR_UPPER_PCT *
+			log(c->calibratedMaxDelta), 0, BAR_LENGTH);
+		exact = (exact < 0) ? 0 : exact;
+		exact = (exact > BAR_LENGTH) ? BAR_LENGTH : exact;
+
+		n = (n > exact) ? n - exact : exact - n;
+		errMax = (n > errMax) ? n : errMax;
+	}
+
+	return errMax;
+}
+
+void setup()
+{
+	uint8_t nCharges;
+
+	Serial.begin(9600);
+
+	#if IS_ATMEGA32U4
+	while(!Serial); /* Required for ATmega32u4 processors */
+	#endif
+
+	Serial.println(F("TouchLib fixed point accuracy (maximum errors)."));
+	printResult("TLLog2Q16():   ", checkLog2(), " ppm");
+	printResult("TLExp2M1Q16(): ", checkExp2M1(), " ppm");
+	for (nCharges = 2; nCharges <= 8; nCharges = nCharges << 1) {
+		Serial.print(F("value, nCharges = "));
+		Serial.print(nCharges);
+		printResult(": ", checkValue(nCharges), " ppm");
+	}
+	printResult("bar length:    ", checkBar(), " characters");
+	Serial.println(F("Done."));
+}
+
+void loop()
+{
+}
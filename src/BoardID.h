@@ -29,10 +29,18 @@
 #ifndef BoardID_h
 #define BoardID_h
 
+#if !defined(SPARK) && !defined(ARDUINO) && defined(__linux__) && \
+		!defined(TL_HOST)
+	/* Not an Arduino or Particle build: use host (Linux) backend */
+	#define TL_HOST
+#endif
+
 #if defined(SPARK)
         #include "application.h"
         #include "Particle.h"
         #include <math.h>
+#elif defined(TL_HOST)
+	#include "TLHost.h"
 #else
 	#if ARDUINO >= 100
 		#include "Arduino.h"
@@ -165,4 +173,7 @@
 /* For ESP32 */
 #define IS_ESP32			(defined(ARDUINO_ARCH_ESP32))
 
+/* Host (Linux) backend with simulated electrodes; see TLHost.h */
+#define IS_HOST				(defined(TL_HOST))
+
 #endif
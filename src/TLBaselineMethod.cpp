@@ -0,0 +1,154 @@
+/*
+ * TLBaselineMethod.cpp - Baseline (avg) and noise power estimators for
+ * TouchLibrary for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "TouchLib.h"
+#include "TLBaselineMethod.h"
+
+/* Returns k such that 2^k is the largest power of 2 not larger than n + 1 */
+static uint8_t shiftForCounter(uint32_t n)
+{
+	uint8_t k = 0;
+
+	n++;
+	while (n > 1) {
+		n >>= 1;
+		k++;
+	}
+
+	return k;
+}
+
+/* Returns x / 2^k, rounded to nearest */
+static int32_t roundedShift(int32_t x, uint8_t k)
+{
+	if (k == 0) {
+		return x;
+	}
+
+	return (x + (((int32_t) 1) << (k - 1))) >> k;
+}
+
+/* Returns x * y if x and y have equal sign, saturated at 0xFFFFFFFF */
+static uint32_t productSaturated(int32_t x, int32_t y)
+{
+	if ((x < 0) && (y < 0)) {
+		x = -x;
+		y = -y;
+	} else if ((x < 0) || (y < 0)) {
+		return 0;
+	}
+
+	if ((x > 0xFFFF) || (y > 0xFFFF)) {
+		return 0xFFFFFFFF;
+	}
+
+	return ((uint32_t) x) * ((uint32_t) y);
+}
+
+/* Returns value << TL_BASELINE_FRACTION_BITS, with value clamped to range */
+static int32_t fixedValue(int32_t value)
+{
+	if (value > TL_BASELINE_VALUE_MAX) {
+		value = TL_BASELINE_VALUE_MAX;
+	} else if (value < -TL_BASELINE_VALUE_MAX) {
+		value = -TL_BASELINE_VALUE_MAX;
+	}
+
+	return value * (((int32_t) 1) << TL_BASELINE_FRACTION_BITS);
+}
+
+/* Exponential moving average with coefficient 1 / 2^k, without division */
+static uint32_t updateNoisePowerEMA(uint32_t noisePower, uint32_t s, uint8_t k)
+{
+	/* Cannot overflow: result is between noisePower and s */
+	return noisePower - (noisePower >> k) + (s >> k);
+}
+
+void TLBaselineMethodAverage(struct TLStruct * d, bool updateNoisePower)
+{
+	uint32_t s;
+
+	d->avg = ((uint32_t) d->counter * d->avg + d->value) /
+		((uint32_t) d->counter + 1);
+
+	if (updateNoisePower) {
+		if (d->delta <= 0xFFFF) {
+			s = d->delta * d->delta;
+		} else {
+			s = 0xFFFFFFFF;
+		}
+		d->noisePower = ((uint32_t) d->noiseCounter * d->noisePower +
+			s) / ((uint32_t) d->noiseCounter + 1);
+	}
+}
+
+void TLBaselineMethodEMA(struct TLStruct * d, bool updateNoisePower)
+{
+	int32_t * avg;
+
+	avg = &(d->tlStructBaselineMethod.ema.avg);
+
+	/* For counter == 0, avg is set to value */
+	*avg += roundedShift(fixedValue(d->value) - *avg,
+		shiftForCounter(d->counter));
+	d->avg = roundedShift(*avg, TL_BASELINE_FRACTION_BITS);
+
+	if (updateNoisePower) {
+		d->noisePower = updateNoisePowerEMA(d->noisePower,
+			productSaturated(d->delta, d->delta),
+			shiftForCounter(d->noiseCounter));
+	}
+}
+
+void TLBaselineMethodWelford(struct TLStruct * d, bool updateNoisePower)
+{
+	int32_t * avg;
+	int32_t diff, incr;
+	uint32_t s;
+
+	avg = &(d->tlStructBaselineMethod.welford.avg);
+
+	diff = fixedValue(d->value) - *avg;
+	incr = roundedShift(diff, shiftForCounter(d->counter));
+	*avg += incr;
+	d->avg = roundedShift(*avg, TL_BASELINE_FRACTION_BITS);
+
+	if (updateNoisePower) {
+		/*
+		 * With a = incr / diff, the variance is updated as:
+		 *   noisePower = (1 - a) * (noisePower + a * diff^2)
+		 * and a * (1 - a) * diff^2 == a * diff * (diff - incr)
+		 */
+		s = productSaturated(roundedShift(diff,
+			TL_BASELINE_FRACTION_BITS), roundedShift(diff - incr,
+			TL_BASELINE_FRACTION_BITS));
+		d->noisePower = updateNoisePowerEMA(d->noisePower, s,
+			shiftForCounter(d->noiseCounter));
+	}
+}
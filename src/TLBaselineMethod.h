@@ -0,0 +1,82 @@
+/*
+ * TLBaselineMethod.h - Baseline (avg) and noise power estimators for
+ * TouchLibrary for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TLBaselineMethod_h
+#define TLBaselineMethod_h
+
+#include <TouchLib.h>
+
+/*
+ * Number of fractional bits of the internal avg of TLBaselineMethodEMA and
+ * TLBaselineMethodWelford. Values must fit in 31 - TL_BASELINE_FRACTION_BITS
+ * bits; larger values (e.g. due to a large scaleFactor or referenceValue) are
+ * clamped to +/- TL_BASELINE_VALUE_MAX before they are averaged.
+ */
+#define TL_BASELINE_FRACTION_BITS			8
+#define TL_BASELINE_VALUE_MAX				((((int32_t) 1) << \
+	(30 - TL_BASELINE_FRACTION_BITS)) - 1)
+
+struct TLStructBaselineMethodEMA {
+	int32_t avg; /* avg << TL_BASELINE_FRACTION_BITS */
+};
+
+struct TLStructBaselineMethodWelford {
+	int32_t avg; /* avg << TL_BASELINE_FRACTION_BITS */
+};
+
+/*
+ * A baseline method is called by TLSensors::updateAvg() and updates avg with
+ * value and, if updateNoisePower is true, noisePower. counter and noiseCounter
+ * count up to filterCoeff - 1 and are incremented after the call, so the
+ * number of values seen so far is counter + 1 (and noiseCounter + 1).
+ *
+ * TLBaselineMethodAverage is the original implementation and the default: avg
+ * is the mean of the first filterCoeff values, followed by an exponential
+ * moving average with coefficient 1 / filterCoeff. noisePower is the same
+ * average of delta^2. It needs two 32 bit divisions per sensor per scan.
+ *
+ * TLBaselineMethodEMA does the same without divisions: the coefficient is
+ * 1 / 2^k with 2^k the largest power of 2 that is not larger than counter + 1,
+ * so it follows the warm-up of TLBaselineMethodAverage and is identical to it
+ * once counter has reached filterCoeff - 1 when filterCoeff is a power of 2.
+ * Other values of filterCoeff are effectively rounded down to a power of 2.
+ * Select it per sensor by setting baselineMethod after initialization.
+ *
+ * TLBaselineMethodWelford uses the same avg, and updates noisePower with the
+ * variance of value around its own running avg (Welford's method with
+ * exponential weights) instead of delta^2. It does not depend on delta from the
+ * previous scan.
+ */
+void TLBaselineMethodAverage(struct TLStruct * d, bool updateNoisePower);
+
+void TLBaselineMethodEMA(struct TLStruct * d, bool updateNoisePower);
+
+void TLBaselineMethodWelford(struct TLStruct * d, bool updateNoisePower);
+
+#endif
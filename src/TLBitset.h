@@ -0,0 +1,163 @@
+/*
+ * TLBitset.h - Packed bit sets for TouchLibrary for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TLBitset_h
+#define TLBitset_h
+
+#include <stdint.h>
+
+/* Number of 32 bit words needed to store nBits bits */
+#define TL_BITSET_WORDS(nBits)		((((uint16_t) (nBits)) + 31) / 32)
+
+/*
+ * Fixed size set of N_BITS bits, packed in 32 bit words. Bit n of word[0] is
+ * element n, so for up to 32 elements word[0] is the same as a uint32_t mask
+ * with (1 << n). The number of words is known at compile time, so for up to
+ * 32 elements every operation compiles to a single word operation.
+ */
+template <uint8_t N_BITS>
+struct TLBitset {
+	uint32_t word[TL_BITSET_WORDS(N_BITS)];
+
+	void clearAll(void)
+	{
+		uint8_t w;
+
+		for (w = 0; w < TL_BITSET_WORDS(N_BITS); w++) {
+			word[w] = 0;
+		}
+	}
+
+	void setAll(void)
+	{
+		uint8_t w;
+
+		for (w = 0; w < TL_BITSET_WORDS(N_BITS); w++) {
+			word[w] = 0xFFFFFFFF;
+		}
+		trim();
+	}
+
+	void set(uint8_t n)
+	{
+		word[n >> 5] |= ((uint32_t) 1) << (n & 31);
+	}
+
+	void clear(uint8_t n)
+	{
+		word[n >> 5] &= ~(((uint32_t) 1) << (n & 31));
+	}
+
+	void assign(uint8_t n, bool value)
+	{
+		if (value) {
+			set(n);
+		} else {
+			clear(n);
+		}
+	}
+
+	bool test(uint8_t n) const
+	{
+		return (word[n >> 5] & (((uint32_t) 1) << (n & 31))) != 0;
+	}
+
+	bool any(void) const
+	{
+		uint8_t w;
+
+		for (w = 0; w < TL_BITSET_WORDS(N_BITS); w++) {
+			if (word[w]) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/* Returns the lowest element in the set, or -1 if the set is empty */
+	int first(void) const
+	{
+		return find(0);
+	}
+
+	/* Returns the lowest element larger than n, or -1 if there is none */
+	int next(uint8_t n) const
+	{
+		return find(((uint16_t) n) + 1);
+	}
+
+	/* Returns the lowest element >= k, or -1 if there is none */
+	int find(uint16_t k) const
+	{
+		uint8_t w, n;
+		uint32_t x;
+
+		for (w = k >> 5; w < TL_BITSET_WORDS(N_BITS); w++) {
+			x = word[w];
+			if (w == (k >> 5)) {
+				x &= ((uint32_t) 0xFFFFFFFF) << (k & 31);
+			}
+			if (x == 0) {
+				continue;
+			}
+			for (n = 0; !(x & 1); n++) {
+				x >>= 1;
+			}
+			return (((uint16_t) w) << 5) + n;
+		}
+
+		return -1;
+	}
+
+	/*
+	 * Sets the first 32 elements to mask. Other elements are set to
+	 * others.
+	 */
+	void fromMask(uint32_t mask, bool others)
+	{
+		uint8_t w;
+
+		word[0] = mask;
+		for (w = 1; w < TL_BITSET_WORDS(N_BITS); w++) {
+			word[w] = others ? 0xFFFFFFFF : 0;
+		}
+		trim();
+	}
+
+	/* Clears the unused bits of the last word */
+	void trim(void)
+	{
+		if (N_BITS & 31) {
+			word[TL_BITSET_WORDS(N_BITS) - 1] &=
+				(((uint32_t) 1) << (N_BITS & 31)) - 1;
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * TLFastGpio.cpp - Fast GPIO access for TouchLibrary for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include "TLFastGpio.h"
+
+#include "BoardID.h"
+
+void TLFastPinInit(struct TLFastPin * p, int pin)
+{
+	p->pin = pin;
+
+	if (pin < 0) {
+		return;
+	}
+
+	#if IS_AVR
+	p->out = portOutputRegister(digitalPinToPort(pin));
+	p->mode = portModeRegister(digitalPinToPort(pin));
+	p->mask = digitalPinToBitMask(pin);
+	#elif IS_TEENSY3X
+	p->set = portSetRegister(pin);
+	p->clear = portClearRegister(pin);
+	p->mode = portModeRegister(pin);
+	p->config = portConfigRegister(pin);
+	#elif IS_PARTICLE
+	p->gpio = PIN_MAP[pin].gpio_peripheral;
+	p->mask = PIN_MAP[pin].gpio_pin;
+	p->modeShift = 2 * PIN_MAP[pin].gpio_pin_source;
+	#endif
+}
@@ -0,0 +1,164 @@
+/*
+ * TLFastGpio.h - Fast GPIO access for TouchLibrary for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TLFastGpio_h
+#define TLFastGpio_h
+
+#include <stdint.h>
+#include "BoardID.h"
+
+#if IS_AVR
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#elif IS_PARTICLE
+#include "pinmap_hal.h"
+#include "stm32f2xx.h"
+#endif
+
+/*
+ * Fast GPIO access. pinMode() and digitalWrite() look up the port of the pin
+ * on every call, which takes several microseconds on AVR and makes the timing
+ * of the charge transfer of the CVD method jitter. TLFastPinInit() looks up
+ * the registers of a pin once; the TLFastPin...() functions below only
+ * write those registers. Boards without a fast implementation fall back to
+ * pinMode() and digitalWrite().
+ *
+ * Input mode also clears the output bit so that no pull-up is enabled, just
+ * like pinMode(pin, INPUT) does on AVR.
+ *
+ * Read-modify-writes of port registers are done with interrupts disabled, so
+ * that an interrupt handler that changes another pin of the same port in
+ * between does not get its change undone.
+ */
+struct TLFastPin {
+	/* pin for which the registers were looked up or -1 */
+	int pin;
+
+	#if IS_AVR
+	volatile uint8_t * out;
+	volatile uint8_t * mode;
+	uint8_t mask;
+	#elif IS_TEENSY3X
+	/* Bit band aliases of the bit of this pin and PCR of the pin */
+	volatile uint8_t * set;
+	volatile uint8_t * clear;
+	volatile uint8_t * mode;
+	volatile uint32_t * config;
+	#elif IS_PARTICLE
+	GPIO_TypeDef * gpio;
+	uint16_t mask;
+	uint8_t modeShift;
+	#endif
+};
+
+void TLFastPinInit(struct TLFastPin * p, int pin);
+
+/* Look up registers again if pin has been changed */
+static inline void TLFastPinUpdate(struct TLFastPin * p, int pin)
+{
+	if (p->pin != pin) {
+		TLFastPinInit(p, pin);
+	}
+}
+
+static inline void TLFastPinHigh(struct TLFastPin * p)
+{
+	#if IS_AVR
+	uint8_t s = SREG;
+	cli();
+	*(p->out) |= p->mask;
+	SREG = s;
+	#elif IS_TEENSY3X
+	*(p->set) = 1;
+	#elif IS_PARTICLE
+	p->gpio->BSRRL = p->mask;
+	#else
+	digitalWrite(p->pin, HIGH);
+	#endif
+}
+
+static inline void TLFastPinLow(struct TLFastPin * p)
+{
+	#if IS_AVR
+	uint8_t s = SREG;
+	cli();
+	*(p->out) &= ~(p->mask);
+	SREG = s;
+	#elif IS_TEENSY3X
+	*(p->clear) = 1;
+	#elif IS_PARTICLE
+	p->gpio->BSRRH = p->mask;
+	#else
+	digitalWrite(p->pin, LOW);
+	#endif
+}
+
+static inline void TLFastPinOutput(struct TLFastPin * p)
+{
+	#if IS_AVR
+	uint8_t s = SREG;
+	cli();
+	*(p->mode) |= p->mask;
+	SREG = s;
+	#elif IS_TEENSY3X
+	*(p->config) = PORT_PCR_SRE | PORT_PCR_DSE | PORT_PCR_MUX(1);
+	*(p->mode) = 1;
+	#elif IS_PARTICLE
+	/* MODER has no set/reset register */
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	p->gpio->MODER = (p->gpio->MODER & ~(((uint32_t) 0x03) <<
+		p->modeShift)) | (((uint32_t) 0x01) << p->modeShift);
+	__set_PRIMASK(primask);
+	#else
+	pinMode(p->pin, OUTPUT);
+	#endif
+}
+
+static inline void TLFastPinInput(struct TLFastPin * p)
+{
+	#if IS_AVR
+	uint8_t s = SREG;
+	cli();
+	*(p->mode) &= ~(p->mask);
+	*(p->out) &= ~(p->mask);
+	SREG = s;
+	#elif IS_TEENSY3X
+	*(p->mode) = 0;
+	*(p->config) = PORT_PCR_MUX(1);
+	#elif IS_PARTICLE
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	p->gpio->MODER &= ~(((uint32_t) 0x03) << p->modeShift);
+	__set_PRIMASK(primask);
+	#else
+	pinMode(p->pin, INPUT);
+	#endif
+}
+
+#endif
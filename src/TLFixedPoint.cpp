@@ -0,0 +1,138 @@
+/*
+ * TLFixedPoint.cpp - Fixed point math for TouchLibrary for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include "TLFixedPoint.h"
+
+#include "BoardID.h"
+
+#if IS_AVR
+#include <avr/pgmspace.h>
+#define TL_TABLE_ATTR					PROGMEM
+#define TL_TABLE_READ(t, k)				pgm_read_word(&((t)[k]))
+#else
+#define TL_TABLE_ATTR
+#define TL_TABLE_READ(t, k)				((t)[k])
+#endif
+
+/* log2(1 + f) / f for f = k / 32 in Q15 format */
+static const uint16_t log2Table[33] TL_TABLE_ATTR = {
+	47274, 46551, 45856, 45188, 44545, 43926, 43328, 42752,
+	42196, 41658, 41137, 40634, 40146, 39673, 39214, 38769,
+	38336, 37916, 37507, 37110, 36723, 36347, 35980, 35622,
+	35274, 34934, 34602, 34278, 33962, 33653, 33352, 33057,
+	32768
+};
+
+/* (pow(2, f) - 1) / f for f = k / 32 in Q16 format (last entry clipped) */
+static const uint16_t exp2m1Table[33] TL_TABLE_ATTR = {
+	45426, 45922, 46424, 46935, 47452, 47977, 48510, 49051,
+	49600, 50156, 50721, 51295, 51876, 52467, 53066, 53674,
+	54292, 54918, 55554, 56200, 56855, 57520, 58195, 58880,
+	59576, 60282, 60999, 61727, 62466, 63216, 63978, 64751,
+	65535
+};
+
+/* Interpolates table at f / 65536 for f in [0, 65536) */
+static uint32_t interpolate(const uint16_t * table, uint16_t f)
+{
+	uint8_t k = f >> 11;
+	uint16_t w = f & 0x07FF;
+	int32_t a, b;
+
+	a = TL_TABLE_READ(table, k);
+	b = TL_TABLE_READ(table, k + 1);
+
+	return a + (((b - a) * (int32_t) w) >> 11);
+}
+
+int32_t TLLog2Q16(uint32_t x)
+{
+	uint8_t e = 31;
+	uint16_t f;
+
+	if (x == 0) {
+		return 0;
+	}
+
+	/* x = pow(2, e) * (1 + f / 65536) */
+	while (!(x & 0x80000000UL)) {
+		x = x << 1;
+		e--;
+	}
+	f = (x >> 15) & 0xFFFF;
+
+	return (((int32_t) e) << 16) + ((((uint32_t) f) *
+		interpolate(log2Table, f)) >> 15);
+}
+
+uint32_t TLExp2M1Q16(uint32_t y)
+{
+	uint16_t yi = y >> 16;
+	uint16_t yf = y & 0xFFFF;
+	uint32_t m;
+
+	/* pow(2, yf / 65536) - 1 in Q16 format */
+	m = ((((uint32_t) yf) * interpolate(exp2m1Table, yf)) + 32768UL) >> 16;
+
+	/* pow(2, y) - 1 = pow(2, yi) * (m + 1) - 1 */
+	if (yi >= 16) {
+		return 0xFFFFFFFFUL;
+	}
+
+	return ((m + 65536UL) << yi) - 65536UL;
+}
+
+uint32_t TLDivQ16(uint32_t a, uint32_t b)
+{
+	uint32_t q, r;
+	uint8_t n;
+
+	q = a / b;
+	if (q > 0xFFFF) {
+		return 0xFFFFFFFFUL;
+	}
+	r = a % b;
+
+	/*
+	 * Long division, 8 fractional bits at a time: r < b < (1 << 24), so
+	 * r << 8 does not overflow
+	 */
+	for (n = 0; n < 2; n++) {
+		r = r << 8;
+		q = (q << 8) + (r / b);
+		r = r % b;
+	}
+
+	/* Round half up */
+	if ((r >= b - (b >> 1)) && (q < 0xFFFFFFFFUL)) {
+		q++;
+	}
+
+	return q;
+}
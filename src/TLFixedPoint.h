@@ -0,0 +1,60 @@
+/*
+ * TLFixedPoint.h - Fixed point math for TouchLibrary for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TLFixedPoint_h
+#define TLFixedPoint_h
+
+#include <stdint.h>
+
+/*
+ * Fixed point approximations of log2() and pow(2, x) - 1 without floating
+ * point math. Numbers in Q16 format have 16 fractional bits (65536 == 1.0).
+ * Both interpolate a 33 entry table of a smooth function that is multiplied by
+ * the fractional part, so the error stays small for arguments close to 0.
+ * TLLog2Q16() has a relative error below 0.001%. TLExp2M1Q16() has a relative
+ * error below 0.01% for results of 0.1 or more and an error below 1 lsb for
+ * smaller results.
+ */
+
+/* Returns log2(x) in Q16 format; x must be larger than 0 (returns 0 if not) */
+int32_t TLLog2Q16(uint32_t x);
+
+/*
+ * Returns pow(2, y / 65536) - 1 in Q16 format; saturates at 0xFFFFFFFF if
+ * result does not fit.
+ */
+uint32_t TLExp2M1Q16(uint32_t y);
+
+/*
+ * Returns a / b in Q16 format, rounded to nearest, with 32 bit operations only
+ * (no 64 bit division). b must be larger than 0 and smaller than 1 << 24;
+ * saturates at 0xFFFFFFFF if result does not fit.
+ */
+uint32_t TLDivQ16(uint32_t a, uint32_t b);
+
+#endif
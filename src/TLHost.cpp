@@ -0,0 +1,453 @@
+/*
+ * TLHost.cpp - Capacitive sensing library based on TL method for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "BoardID.h"
+
+#if IS_HOST
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TL_HOST_ADC_MAX			((1 << TL_HOST_ADC_RESOLUTION_BIT) - 1)
+
+struct TLHostPin {
+	int mode;
+	int level;
+	float voltage; /* relative to Vdd */
+	float capacitance; /* pF */
+	float resistance; /* Ohm */
+};
+
+static struct TLHostPin pins[TL_HOST_N_PINS];
+static bool pinsInitialized = false;
+static float adcHoldVoltage[TL_HOST_ADC_N_MODULES];
+static float noiseRms = TL_HOST_NOISE_DEFAULT;
+static uint32_t randomState = 1;
+static uint32_t noiseState = 0x12345678;
+static struct timespec startTime;
+static bool startTimeInitialized = false;
+
+TLHostSerial Serial;
+
+static struct TLHostPin * getPin(int pin)
+{
+	if (!pinsInitialized) {
+		TLHostReset();
+	}
+
+	if ((pin < 0) || (pin >= TL_HOST_N_PINS)) {
+		return NULL;
+	}
+
+	return &(pins[pin]);
+}
+
+static uint32_t xorShift(uint32_t * state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return x;
+}
+
+static float gaussianNoise(void)
+{
+	float u1, u2;
+
+	/* Box-Muller transform; u1 must not be 0 */
+	u1 = ((float) (xorShift(&noiseState) >> 8) + 1.0f) / 16777217.0f;
+	u2 = ((float) (xorShift(&noiseState) >> 8)) / 16777216.0f;
+
+	return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float) M_PI * u2);
+}
+
+/*
+ * Voltage of a pin that is actively driven (output or pull-up). Returns a
+ * negative value if the pin is floating.
+ */
+static float drivenVoltage(struct TLHostPin * p)
+{
+	float v = -1.0f;
+
+	if (p->mode == OUTPUT) {
+		v = p->level ? 1.0f : 0.0f;
+	} else if (p->mode == INPUT_PULLUP) {
+		v = p->resistance / (p->resistance +
+			TL_HOST_PULLUP_RESISTANCE_DEFAULT);
+	}
+
+	return v;
+}
+
+void TLHostReset(void)
+{
+	int n;
+
+	for (n = 0; n < TL_HOST_N_PINS; n++) {
+		pins[n].mode = INPUT;
+		pins[n].level = LOW;
+		pins[n].voltage = 0.0f;
+		pins[n].capacitance = TL_HOST_PIN_CAPACITANCE_DEFAULT;
+		pins[n].resistance = TL_HOST_PIN_RESISTANCE_DEFAULT;
+	}
+	for (n = 0; n < TL_HOST_ADC_N_MODULES; n++) {
+		adcHoldVoltage[n] = 0.0f;
+	}
+	pinsInitialized = true;
+}
+
+void TLHostSetCapacitance(int pin, float capacitance)
+{
+	struct TLHostPin * p = getPin(pin);
+
+	if (p != NULL) {
+		p->capacitance = capacitance;
+	}
+}
+
+float TLHostGetCapacitance(int pin)
+{
+	struct TLHostPin * p = getPin(pin);
+
+	return (p != NULL) ? p->capacitance : 0.0f;
+}
+
+void TLHostSetResistance(int pin, float resistance)
+{
+	struct TLHostPin * p = getPin(pin);
+
+	if (p != NULL) {
+		p->resistance = resistance;
+	}
+}
+
+float TLHostGetResistance(int pin)
+{
+	struct TLHostPin * p = getPin(pin);
+
+	return (p != NULL) ? p->resistance : 0.0f;
+}
+
+void TLHostSetNoise(float rms)
+{
+	noiseRms = rms;
+}
+
+int8_t TLHostAdcModule(int pin)
+{
+	if ((pin < A0) || (pin >= TL_HOST_N_PINS)) {
+		return -1;
+	}
+
+	return ((pin - A0) >> 3) % TL_HOST_ADC_N_MODULES;
+}
+
+void TLHostSetAdcMux(int pin)
+{
+	struct TLHostPin * p = getPin(pin);
+	int8_t m = TLHostAdcModule(pin);
+	float v, c_h;
+
+	if ((p == NULL) || (m < 0)) {
+		return;
+	}
+
+	v = drivenVoltage(p);
+	if (v >= 0.0f) {
+		/* Driven pin charges sample and hold capacitor */
+		adcHoldVoltage[m] = v;
+	} else {
+		/* Floating pin shares its charge with sample and hold cap */
+		c_h = TL_HOST_ADC_HOLD_CAPACITANCE_DEFAULT;
+		v = (c_h * adcHoldVoltage[m] + p->capacitance * p->voltage) /
+			(c_h + p->capacitance);
+		adcHoldVoltage[m] = v;
+		p->voltage = v;
+	}
+}
+
+void pinMode(int pin, int mode)
+{
+	struct TLHostPin * p = getPin(pin);
+
+	if (p == NULL) {
+		return;
+	}
+
+	p->mode = mode;
+	if (mode == OUTPUT) {
+		p->voltage = p->level ? 1.0f : 0.0f;
+	} else if (mode == INPUT_PULLUP) {
+		p->level = HIGH;
+		p->voltage = drivenVoltage(p);
+	} else {
+		p->level = LOW;
+	}
+}
+
+void digitalWrite(int pin, int value)
+{
+	struct TLHostPin * p = getPin(pin);
+
+	if (p == NULL) {
+		return;
+	}
+
+	p->level = value ? HIGH : LOW;
+	if (p->mode == OUTPUT) {
+		p->voltage = p->level ? 1.0f : 0.0f;
+	} else if ((p->mode == INPUT) && (p->level == HIGH)) {
+		/* Writing HIGH to an input enables the pull-up */
+		pinMode(pin, INPUT_PULLUP);
+	} else if ((p->mode == INPUT_PULLUP) && (p->level == LOW)) {
+		p->mode = INPUT;
+	}
+}
+
+int digitalRead(int pin)
+{
+	struct TLHostPin * p = getPin(pin);
+
+	if (p == NULL) {
+		return LOW;
+	}
+
+	if ((p->mode == OUTPUT) || (p->mode == INPUT_PULLUP)) {
+		p->voltage = drivenVoltage(p);
+	}
+
+	return (p->voltage > 0.5f) ? HIGH : LOW;
+}
+
+int analogRead(int pin)
+{
+	float v;
+	int32_t value;
+
+	/* Accept both channel numbers and A0 - A31 notation, like AVR */
+	if (pin < A0) {
+		pin += A0;
+	}
+
+	TLHostSetAdcMux(pin);
+	if (TLHostAdcModule(pin) < 0) {
+		return 0;
+	}
+
+	v = adcHoldVoltage[TLHostAdcModule(pin)] * (float) TL_HOST_ADC_MAX;
+	if (noiseRms > 0.0f) {
+		v += noiseRms * gaussianNoise();
+	}
+	value = (int32_t) (v + 0.5f);
+	value = (value < 0) ? 0 : value;
+	value = (value > TL_HOST_ADC_MAX) ? TL_HOST_ADC_MAX : value;
+
+	return value;
+}
+
+int touchRead(int pin)
+{
+	struct TLHostPin * p = getPin(pin);
+	float v;
+
+	if (p == NULL) {
+		return 0;
+	}
+
+	v = p->capacitance / TL_HOST_TOUCH_LSB_DEFAULT;
+	if (noiseRms > 0.0f) {
+		v += noiseRms * gaussianNoise();
+	}
+
+	return (v < 0.0f) ? 0 : (int) (v + 0.5f);
+}
+
+unsigned long micros(void)
+{
+	struct timespec now;
+
+	if (!startTimeInitialized) {
+		clock_gettime(CLOCK_MONOTONIC, &startTime);
+		startTimeInitialized = true;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (unsigned long) ((now.tv_sec - startTime.tv_sec) * 1000000L +
+		(now.tv_nsec - startTime.tv_nsec) / 1000L);
+}
+
+unsigned long millis(void)
+{
+	return micros() / 1000UL;
+}
+
+void delay(unsigned long ms)
+{
+	unsigned long start = millis();
+
+	while (millis() - start < ms);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	unsigned long start = micros();
+
+	while (micros() - start < us);
+}
+
+void randomSeed(unsigned long seed)
+{
+	randomState = (seed != 0) ? (uint32_t) seed : 1;
+}
+
+long random(long max)
+{
+	if (max <= 0) {
+		return 0;
+	}
+
+	return (long) (xorShift(&randomState) % (uint32_t) max);
+}
+
+long random(long min, long max)
+{
+	if (min >= max) {
+		return min;
+	}
+
+	return random(max - min) + min;
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+	if (inMax == inMin) {
+		return outMin;
+	}
+
+	return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+void TLHostSerial::begin(unsigned long baud)
+{
+	micros(); /* start the clock */
+}
+
+size_t TLHostSerial::print(const char * s)
+{
+	return fputs(s, stdout) >= 0 ? strlen(s) : 0;
+}
+
+size_t TLHostSerial::print(char c)
+{
+	return (fputc(c, stdout) != EOF) ? 1 : 0;
+}
+
+size_t TLHostSerial::print(long n, int base)
+{
+	if (base == DEC) {
+		return printf("%ld", n);
+	}
+
+	return print((unsigned long) n, base);
+}
+
+size_t TLHostSerial::print(unsigned long n, int base)
+{
+	char s[8 * sizeof(long) + 1];
+	int k = sizeof(s) - 1;
+
+	if ((base < 2) || (base > 16)) {
+		base = DEC;
+	}
+
+	s[k] = '\0';
+	do {
+		s[--k] = "0123456789ABCDEF"[n % base];
+		n /= base;
+	} while (n > 0);
+
+	return print(&(s[k]));
+}
+
+size_t TLHostSerial::print(int n, int base)
+{
+	return print((long) n, base);
+}
+
+size_t TLHostSerial::print(unsigned int n, int base)
+{
+	return print((unsigned long) n, base);
+}
+
+size_t TLHostSerial::print(double n, int digits)
+{
+	return printf("%.*f", digits, n);
+}
+
+size_t TLHostSerial::println(void)
+{
+	return print('\n');
+}
+
+int TLHostSerial::available(void)
+{
+	return 0;
+}
+
+int TLHostSerial::read(void)
+{
+	return -1;
+}
+
+void TLHostSerial::flush(void)
+{
+	fflush(stdout);
+}
+
+extern void setup(void);
+extern void loop(void);
+
+int main(void)
+{
+	unsigned long n;
+
+	setup();
+	for (n = 0; n < TL_HOST_LOOP_COUNT; n++) {
+		loop();
+	}
+	fflush(stdout);
+
+	return 0;
+}
+
+#endif
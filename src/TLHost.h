@@ -0,0 +1,169 @@
+/*
+ * TLHost.h - Capacitive sensing library based on TL method for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TLHost_h
+#define TLHost_h
+
+/*
+ * Host (Linux) board backend. Provides the small subset of the Arduino API
+ * that TouchLib uses, together with a simple electrical model of the
+ * electrodes so that the CVD, resistive and touchRead sample methods produce
+ * realistic values. This allows to run and benchmark TouchLib on a PC, for
+ * example with:
+ *
+ *   g++ -O2 -DTL_HOST -Isrc -x c++ \
+ *     examples/Example01ScanBenchmark/Example01ScanBenchmark.ino \
+ *     -x none src/TL*.cpp -o scanbenchmark
+ *
+ * The host backend provides main(), which calls setup() once and then calls
+ * loop() TL_HOST_LOOP_COUNT times.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef TL_HOST_LOOP_COUNT
+#define TL_HOST_LOOP_COUNT				1
+#endif
+
+#define TL_HOST_N_PINS					64
+
+#define HIGH						1
+#define LOW						0
+
+#define INPUT						0
+#define OUTPUT						1
+#define INPUT_PULLUP					2
+
+#define DEC						10
+#define HEX						16
+
+/* Pins 0 - 13 are digital only; pins A0 - A31 are analog inputs */
+#define A0						14
+#define A1						(A0 + 1)
+#define A2						(A0 + 2)
+#define A3						(A0 + 3)
+#define A4						(A0 + 4)
+#define A5						(A0 + 5)
+#define A6						(A0 + 6)
+#define A7						(A0 + 7)
+#define A8						(A0 + 8)
+#define A9						(A0 + 9)
+#define A10						(A0 + 10)
+#define A11						(A0 + 11)
+#define A12						(A0 + 12)
+#define A13						(A0 + 13)
+#define A14						(A0 + 14)
+#define A15						(A0 + 15)
+
+#define F(s)						(s)
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+/* Default electrical properties of the simulated hardware */
+#define TL_HOST_ADC_RESOLUTION_BIT			10
+#ifndef TL_HOST_ADC_N_MODULES
+/*
+ * Set to 2 to simulate a second ADC module (like on Teensy 3.x); analog pins
+ * are then assigned to the modules in blocks of 8 (A0 - A7 to ADC0, A8 - A15
+ * to ADC1, A16 - A23 to ADC0, ...).
+ */
+#define TL_HOST_ADC_N_MODULES				1
+#endif
+#define TL_HOST_ADC_HOLD_CAPACITANCE_DEFAULT		14.0f /* pF */
+#define TL_HOST_PIN_CAPACITANCE_DEFAULT			20.0f /* pF */
+#define TL_HOST_PIN_RESISTANCE_DEFAULT			1.0e12f /* Ohm */
+#define TL_HOST_PULLUP_RESISTANCE_DEFAULT		35000.0f /* Ohm */
+#define TL_HOST_TOUCH_LSB_DEFAULT			0.02f /* pF per count */
+#define TL_HOST_NOISE_DEFAULT				0.5f /* rms, in lsb */
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+int analogRead(int pin);
+int touchRead(int pin);
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+/*
+ * Electrode model. Every pin has a capacitance to ground (parasitic plus
+ * electrode; add a few pF to simulate a touch) and a resistance to ground
+ * (infinite when not pressed; used by resistive sensors). Selecting a floating
+ * pin with the ADC multiplexer shares the charge of the pin with the sample and
+ * hold capacitor of its ADC module, just like on real hardware.
+ */
+void TLHostSetCapacitance(int pin, float capacitance);
+float TLHostGetCapacitance(int pin);
+void TLHostSetResistance(int pin, float resistance);
+float TLHostGetResistance(int pin);
+void TLHostSetNoise(float rms);
+void TLHostSetAdcMux(int pin);
+int8_t TLHostAdcModule(int pin);
+void TLHostReset(void);
+
+class TLHostSerial
+{
+	public:
+		void begin(unsigned long baud);
+		size_t print(const char * s);
+		size_t print(char c);
+		size_t print(int n, int base = DEC);
+		size_t print(unsigned int n, int base = DEC);
+		size_t print(long n, int base = DEC);
+		size_t print(unsigned long n, int base = DEC);
+		size_t print(double n, int digits = 2);
+		size_t println(void);
+		template <typename T> size_t println(T x)
+		{
+			size_t n = print(x);
+			return n + println();
+		}
+		template <typename T> size_t println(T x, int f)
+		{
+			size_t n = print(x, f);
+			return n + println();
+		}
+		int available(void);
+		int read(void);
+		void flush(void);
+		operator bool(void) { return true; }
+};
+
+extern TLHostSerial Serial;
+
+#endif
@@ -0,0 +1,252 @@
+/*
+ * TLMedian.h - Compile time median kernels for TouchLibrary for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TLMedian_h
+#define TLMedian_h
+
+#include <stdint.h>
+
+/*
+ * Sorts a and b without branches: min / max compile to conditional moves (or
+ * conditional execution on ARM Thumb-2, such as the Cortex-M4 of Teensy 3.x
+ * and Particle).
+ */
+static inline void TLCompareExchange(int32_t * a, int32_t * b)
+{
+	int32_t lo, hi;
+
+	lo = (*a < *b) ? *a : *b;
+	hi = (*a < *b) ? *b : *a;
+	*a = lo;
+	*b = hi;
+}
+
+/* Returns the average of a and b without overflow, rounded down */
+static inline int32_t TLMedianAverage(int32_t a, int32_t b)
+{
+	return a + ((b - a) >> 1);
+}
+
+/*
+ * TLMedian<N>::median(buf) returns the median of the N values in buf and
+ * reorders buf. For even N, the average of the two middle values is returned.
+ *
+ * N is a compile time constant (typically N_MEASUREMENTS_PER_SENSOR). Sizes up
+ * to 8 use an optimal sorting network of compare-exchange operations that is
+ * fully unrolled; larger sizes use quickselect (Wirth's variant), which takes
+ * O(N) operations on average instead of sorting the whole buffer.
+ */
+template <uint8_t N>
+struct TLMedian {
+	static int32_t select(int32_t * buf, int16_t k)
+	{
+		int16_t l, m, i, j;
+		int32_t x, tmp;
+
+		l = 0;
+		m = N - 1;
+		while (l < m) {
+			x = buf[k];
+			i = l;
+			j = m;
+			do {
+				while (buf[i] < x) {
+					i++;
+				}
+				while (x < buf[j]) {
+					j--;
+				}
+				if (i <= j) {
+					tmp = buf[i];
+					buf[i] = buf[j];
+					buf[j] = tmp;
+					i++;
+					j--;
+				}
+			} while (i <= j);
+			if (j < k) {
+				l = i;
+			}
+			if (k < i) {
+				m = j;
+			}
+		}
+
+		return buf[k];
+	}
+
+	static int32_t median(int32_t * buf)
+	{
+		int32_t hi, lo;
+		uint8_t n;
+
+		hi = select(buf, N / 2);
+		if (N & 0x01) {
+			return hi;
+		}
+
+		/* All values below N / 2 are not larger than hi */
+		lo = buf[0];
+		for (n = 1; n < N / 2; n++) {
+			lo = (buf[n] > lo) ? buf[n] : lo;
+		}
+
+		return TLMedianAverage(lo, hi);
+	}
+};
+
+template <>
+struct TLMedian<1> {
+	static int32_t median(int32_t * buf)
+	{
+		return buf[0];
+	}
+};
+
+template <>
+struct TLMedian<2> {
+	static int32_t median(int32_t * buf)
+	{
+		TLCompareExchange(&buf[0], &buf[1]);
+		return TLMedianAverage(buf[0], buf[1]);
+	}
+};
+
+template <>
+struct TLMedian<3> {
+	static int32_t median(int32_t * buf)
+	{
+		TLCompareExchange(&buf[1], &buf[2]);
+		TLCompareExchange(&buf[0], &buf[2]);
+		TLCompareExchange(&buf[0], &buf[1]);
+		return buf[1];
+	}
+};
+
+template <>
+struct TLMedian<4> {
+	static int32_t median(int32_t * buf)
+	{
+		TLCompareExchange(&buf[0], &buf[1]);
+		TLCompareExchange(&buf[2], &buf[3]);
+		TLCompareExchange(&buf[0], &buf[2]);
+		TLCompareExchange(&buf[1], &buf[3]);
+		TLCompareExchange(&buf[1], &buf[2]);
+		return TLMedianAverage(buf[1], buf[2]);
+	}
+};
+
+template <>
+struct TLMedian<5> {
+	static int32_t median(int32_t * buf)
+	{
+		TLCompareExchange(&buf[0], &buf[1]);
+		TLCompareExchange(&buf[3], &buf[4]);
+		TLCompareExchange(&buf[2], &buf[4]);
+		TLCompareExchange(&buf[2], &buf[3]);
+		TLCompareExchange(&buf[1], &buf[4]);
+		TLCompareExchange(&buf[0], &buf[3]);
+		TLCompareExchange(&buf[0], &buf[2]);
+		TLCompareExchange(&buf[1], &buf[3]);
+		TLCompareExchange(&buf[1], &buf[2]);
+		return buf[2];
+	}
+};
+
+template <>
+struct TLMedian<6> {
+	static int32_t median(int32_t * buf)
+	{
+		TLCompareExchange(&buf[1], &buf[2]);
+		TLCompareExchange(&buf[4], &buf[5]);
+		TLCompareExchange(&buf[0], &buf[2]);
+		TLCompareExchange(&buf[3], &buf[5]);
+		TLCompareExchange(&buf[0], &buf[1]);
+		TLCompareExchange(&buf[3], &buf[4]);
+		TLCompareExchange(&buf[1], &buf[4]);
+		TLCompareExchange(&buf[0], &buf[3]);
+		TLCompareExchange(&buf[2], &buf[5]);
+		TLCompareExchange(&buf[1], &buf[3]);
+		TLCompareExchange(&buf[2], &buf[4]);
+		TLCompareExchange(&buf[2], &buf[3]);
+		return TLMedianAverage(buf[2], buf[3]);
+	}
+};
+
+template <>
+struct TLMedian<7> {
+	static int32_t median(int32_t * buf)
+	{
+		TLCompareExchange(&buf[1], &buf[2]);
+		TLCompareExchange(&buf[3], &buf[4]);
+		TLCompareExchange(&buf[5], &buf[6]);
+		TLCompareExchange(&buf[0], &buf[2]);
+		TLCompareExchange(&buf[3], &buf[5]);
+		TLCompareExchange(&buf[4], &buf[6]);
+		TLCompareExchange(&buf[0], &buf[1]);
+		TLCompareExchange(&buf[4], &buf[5]);
+		TLCompareExchange(&buf[2], &buf[6]);
+		TLCompareExchange(&buf[0], &buf[4]);
+		TLCompareExchange(&buf[1], &buf[5]);
+		TLCompareExchange(&buf[0], &buf[3]);
+		TLCompareExchange(&buf[2], &buf[5]);
+		TLCompareExchange(&buf[1], &buf[3]);
+		TLCompareExchange(&buf[2], &buf[4]);
+		TLCompareExchange(&buf[2], &buf[3]);
+		return buf[3];
+	}
+};
+
+template <>
+struct TLMedian<8> {
+	static int32_t median(int32_t * buf)
+	{
+		TLCompareExchange(&buf[0], &buf[2]);
+		TLCompareExchange(&buf[1], &buf[3]);
+		TLCompareExchange(&buf[4], &buf[6]);
+		TLCompareExchange(&buf[5], &buf[7]);
+		TLCompareExchange(&buf[0], &buf[4]);
+		TLCompareExchange(&buf[1], &buf[5]);
+		TLCompareExchange(&buf[2], &buf[6]);
+		TLCompareExchange(&buf[3], &buf[7]);
+		TLCompareExchange(&buf[0], &buf[1]);
+		TLCompareExchange(&buf[2], &buf[3]);
+		TLCompareExchange(&buf[4], &buf[5]);
+		TLCompareExchange(&buf[6], &buf[7]);
+		TLCompareExchange(&buf[2], &buf[4]);
+		TLCompareExchange(&buf[3], &buf[5]);
+		TLCompareExchange(&buf[1], &buf[4]);
+		TLCompareExchange(&buf[3], &buf[6]);
+		TLCompareExchange(&buf[1], &buf[2]);
+		TLCompareExchange(&buf[3], &buf[4]);
+		TLCompareExchange(&buf[5], &buf[6]);
+		return TLMedianAverage(buf[3], buf[4]);
+	}
+};
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * TLRunningMedian.cpp - Running median over scans for TouchLibrary for
+ * Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "TLRunningMedian.h"
+
+int32_t TLRunningMedianAdd(int32_t * buf, uint8_t * age, uint8_t * n,
+		uint8_t length, int32_t x)
+{
+	uint8_t k, m, oldest;
+
+	if (*n > length) {
+		*n = 0;
+	}
+
+	if (*n < length) {
+		/* Window not yet full: use a new slot at the end */
+		oldest = *n;
+		(*n)++;
+	} else {
+		oldest = 0;
+	}
+
+	/* Age all values and find the value that leaves the window */
+	m = *n;
+	for (k = 0; k < m; k++) {
+		if (++age[k] >= length) {
+			oldest = k;
+		}
+	}
+
+	/* Replace oldest value by x and shift x to its sorted position */
+	k = oldest;
+	while ((k > 0) && (buf[k - 1] > x)) {
+		buf[k] = buf[k - 1];
+		age[k] = age[k - 1];
+		k--;
+	}
+	while ((k < m - 1) && (buf[k + 1] < x)) {
+		buf[k] = buf[k + 1];
+		age[k] = age[k + 1];
+		k++;
+	}
+	buf[k] = x;
+	age[k] = 0;
+
+	if (m & 0x01) {
+		return buf[m >> 1];
+	} else {
+		return buf[(m >> 1) - 1] + ((buf[m >> 1] - buf[(m >> 1) - 1])
+			>> 1);
+	}
+}
@@ -0,0 +1,51 @@
+/*
+ * TLRunningMedian.h - Running median over scans for TouchLibrary for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TLRunningMedian_h
+#define TLRunningMedian_h
+
+#include <stdint.h>
+
+/*
+ * Running median over the last length values added. buf holds the values in
+ * sorted order and age[k] the number of values added after buf[k]. Both must
+ * have room for length values (at most 255). n is the number of values in buf
+ * and must be set to 0 to start a new window; the window is also restarted
+ * when n is larger than length.
+ *
+ * Adding a value replaces the oldest value (once the window is full) and
+ * restores the order by shifting the values between the old and the new
+ * position, so it costs O(length) operations regardless of the input.
+ *
+ * Returns the median of the values in the window. For an even number of
+ * values, the average of the two middle values is returned.
+ */
+int32_t TLRunningMedianAdd(int32_t * buf, uint8_t * age, uint8_t * n,
+	uint8_t length, int32_t x);
+
+#endif
@@ -31,37 +31,24 @@
 #include <stdint.h>
 #include "TouchLib.h"
 #include "TLSampleMethodCVD.h"
+#include "TLFixedPoint.h"
 #include "BoardID.h"
 
-#if IS_ATMEGA
-#include "TLSampleMethodCVDATMega.h"
-#elif IS_TEENSY3X
-#include "TLSampleMethodCVDTeensy3x.h"
-#elif IS_PARTICLE
-#include "TLSampleMethodCVDParticle.h"
-#elif IS_ESP32
-#include "TLSampleMethodCVDEsp32.h"
-#endif
-
+/* Board specific definitions are included by TLSampleMethodCVDInline.h */
 #ifndef TL_METHOD_CVD_SUPPORTED
-#include "TLSampleMethodCVDUnsupported.h"
-#endif
-
-#define TL_USE_N_CHARGES_PADDING_DEFAULT		true
-
-#define TL_REFERENCE_VALUE_DEFAULT			((int32_t) 15000) /* 15 pF */
-#define TL_SCALE_FACTOR_DEFAULT				((int32_t) 1)
-#define TL_OFFSET_VALUE_DEFAULT				((int32_t) 1000000) /* fF */
+#warning "CVD method is not supported on this processor"
 
-#define TL_SET_OFFSET_VALUE_MANUALLY_DEFAULT		false
+void TLSetAdcReferencePin(int pin)
+{
+}
 
-#define TL_RELEASED_TO_APPROACHED_THRESHOLD_DEFAULT	5.0
-#define TL_APPROACHED_TO_RELEASED_THRESHOLD_DEFAULT	4.0
-#define TL_APPROACHED_TO_PRESSED_THRESHOLD_DEFAULT	10.0
-#define TL_PRESSED_TO_APPROACHED_THRESHOLD_DEFAULT	80.0
+int TLAnalogRead(int pin)
+{
+	return 0;
+}
+#endif
 
-static uint8_t TLChannelToReference(struct TLStruct * data, uint8_t nSensors,
-		uint8_t ch)
+uint8_t TLFindReference(struct TLStruct * data, uint8_t nSensors, uint8_t ch)
 {
 	uint8_t ref;
 
@@ -80,249 +67,400 @@ static uint8_t TLChannelToReference(struct TLStruct * data, uint8_t nSensors,
 			 */
 			ref = 0xFF;
 		}
-	} while ((ref != 0xFF) && (data[ref].sampleMethod !=
+	} while ((ref != 0xFF) && (TL_CONFIG(&(data[ref]), sampleMethod) !=
 		TLSampleMethodCVD));
 
 	return ref;
 }
 
-static void TLSetSensorAndReferencePins(int ch_pin, int ref_pin, bool inv)
+void TLSampleMethodCVDInvalidateReferences(struct TLStruct * data,
+		uint8_t nSensors)
 {
-	/* Set reference pin as output and high. */
+	uint8_t ch;
 
-	pinMode(ref_pin, OUTPUT);
-	if (inv) {
-		digitalWrite(ref_pin, LOW);
-	} else {
-		digitalWrite(ref_pin, HIGH);
+	for (ch = 0; ch < nSensors; ch++) {
+		if (TL_CONFIG(&(data[ch]), sampleMethod) == TLSampleMethodCVD) {
+			data[ch].tlStructSampleMethodState.CVD.referenceChannelCache =
+				TL_REFERENCE_CHANNEL_CACHE_INVALID;
+		}
 	}
+}
+
+/*
+ * Background scanning. Conversions are grouped: a group measures one position
+ * or, on boards with more than one ADC module (TL_ADC_N_MODULES > 1), up to one
+ * position per module simultaneously. The partner of a position is searched in
+ * the next TL_BACKGROUND_LOOK_AHEAD positions of scanOrder. bgNext is the first
+ * position that has not yet been measured; bit n of bgAhead is set if position
+ * bgNext + 1 + n has already been measured as a partner. Positions that are
+ * marked TL_BACKGROUND_POSITION_SKIPPED in bgResults are passed over like
+ * positions that have already been measured.
+ *
+ * The engine is only built on boards that define
+ * TL_METHOD_CVD_BACKGROUND_SUPPORTED.
+ */
+#if defined(TL_METHOD_CVD_BACKGROUND_SUPPORTED)
+#if !defined(TL_ADC_N_MODULES)
+#define TL_ADC_N_MODULES				1
+#endif
 
-	/* Set sensor pin as output and low (discharge sensor). */
-	pinMode(ch_pin, OUTPUT);
-	if (inv) {
-		digitalWrite(ch_pin, HIGH);
-	} else {
-		digitalWrite(ch_pin, LOW);
+#define TL_BACKGROUND_LOOK_AHEAD			8
+/* A group has at most two lanes (positions measured simultaneously) */
+#define TL_BACKGROUND_N_LANES				2
+
+static struct TLStruct * bgData = NULL;
+static uint8_t bgNSensors;
+static const uint8_t * bgScanOrder;
+static bool bgScanOrderInFlash;
+static uint16_t bgLength;
+static uint16_t * bgResults;
+static volatile uint16_t bgNext;
+static volatile uint8_t bgAhead;
+static volatile bool bgInv;
+static volatile bool bgBusy = false;
+static uint16_t bgLanePos[TL_BACKGROUND_N_LANES];
+static int8_t bgLaneModule[TL_BACKGROUND_N_LANES];
+static uint8_t bgNLanes;
+static volatile uint8_t bgNLanesBusy;
+
+static uint8_t bgChannel(uint16_t pos)
+{
+	#if IS_AVR
+	if (bgScanOrderInFlash) {
+		return TL_SCAN_ORDER_READ(bgScanOrder, pos);
 	}
+	#endif
+
+	return bgScanOrder[pos];
 }
 
-static void TLChargeADC(struct TLStruct * data, uint8_t nSensors, uint8_t ch, 
-		int ref_pin, bool delay)
+static int bgSensorPin(uint16_t pos)
 {
-	/* Set ADC to reference pin (charge Chold). */
-	TLSetAdcReferencePin(ref_pin);
+	return TL_CONFIG(&(bgData[bgChannel(pos)]),
+		tlStructSampleMethod.CVD.pin);
+}
 
-	if ((delay) && (data[ch].tlStructSampleMethod.CVD.chargeDelayADC)) {
-		delayMicroseconds(data[ch].tlStructSampleMethod.CVD.chargeDelayADC);
-	}
+static int bgReferencePin(uint16_t pos)
+{
+	uint8_t ref;
+
+	ref = TLChannelToReference(bgData, bgNSensors, bgChannel(pos));
+
+	return TL_CONFIG(&(bgData[ref]), tlStructSampleMethod.CVD.pin);
 }
 
-static void TLChargeSensor(struct TLStruct * data, uint8_t nSensors, uint8_t ch,
-		int ch_pin, bool delay)
+static bool bgSkipped(uint16_t pos)
 {
-	/*
-	 * Set ADC to sensor pin (transfer charge from Chold to Csense).
-	 */
-	TLSetAdcReferencePin(ch_pin);
+	return (bgResults[2 * pos] == TL_BACKGROUND_POSITION_SKIPPED);
+}
 
-	if ((delay) && (data[ch].tlStructSampleMethod.CVD.chargeDelaySensor)) {
-		delayMicroseconds(data[ch].tlStructSampleMethod.CVD.chargeDelaySensor);
-	}
+/* Advance bgNext past measured and skipped positions */
+static void bgAdvance(void)
+{
+	bool done;
+
+	do {
+		bgNext = bgNext + 1;
+		done = (bgAhead & 0x01) || ((bgNext < bgLength) &&
+			bgSkipped(bgNext));
+		bgAhead = bgAhead >> 1;
+	} while (done);
 }
 
-static void TLDischargeSensor(struct TLStruct * data, uint8_t nSensors, uint8_t ch,
-		bool delay)
+static struct TLFastPin * bgSensorFastPin(uint16_t pos)
 {
-	pinMode(data[ch].tlStructSampleMethod.CVD.pin, OUTPUT);
-	digitalWrite(data[ch].tlStructSampleMethod.CVD.pin, LOW);
+	return &(bgData[bgChannel(pos)].tlStructSampleMethodState.CVD.fastPin);
+}
 
-	if ((delay) && (data[ch].tlStructSampleMethod.CVD.chargeDelaySensor)) {
-		delayMicroseconds(data[ch].tlStructSampleMethod.CVD.chargeDelaySensor);
-	}
+static struct TLFastPin * bgReferenceFastPin(uint16_t pos)
+{
+	uint8_t ref;
+
+	ref = TLChannelToReference(bgData, bgNSensors, bgChannel(pos));
+
+	return &(bgData[ref].tlStructSampleMethodState.CVD.fastPin);
 }
 
-static void TLCharge(struct TLStruct * data, uint8_t nSensors, uint8_t ch,
-		int ch_pin, int ref_pin)
+#if (TL_ADC_N_MODULES > 1)
+static void bgFindPartner(void)
 {
-	unsigned int d;
+	uint16_t pos, p0;
+	uint8_t n;
+	int8_t m0, m;
+	int ch0_pin, ref0_pin, ch_pin, ref_pin;
+
+	p0 = bgLanePos[0];
+	ch0_pin = bgSensorPin(p0);
+	ref0_pin = bgReferencePin(p0);
+	m0 = TLAdcModule(ch0_pin);
+
+	/* Reference must charge the ADC module that converts the sensor */
+	if ((m0 < 0) || (TLAdcModule(ref0_pin) != m0)) {
+		return;
+	}
+	bgLaneModule[0] = m0;
 
-	TLChargeADC(data, nSensors, ch, ref_pin, false);
-	TLChargeSensor(data, nSensors, ch, ch_pin, false);
+	for (n = 0; n < TL_BACKGROUND_LOOK_AHEAD; n++) {
+		pos = p0 + 1 + n;
+		if (pos >= bgLength) {
+			break;
+		}
+		if ((bgAhead & (1 << n)) || bgSkipped(pos)) {
+			/* Already measured or not to be measured */
+			continue;
+		}
 
-	d = (data[ch].tlStructSampleMethod.CVD.chargeDelayADC >
-			data[ch].tlStructSampleMethod.CVD.chargeDelaySensor) ?
-		data[ch].tlStructSampleMethod.CVD.chargeDelayADC :
-			data[ch].tlStructSampleMethod.CVD.chargeDelaySensor;
+		ch_pin = bgSensorPin(pos);
+		ref_pin = bgReferencePin(pos);
+		m = TLAdcModule(ch_pin);
+		if ((m < 0) || (m == m0) || (TLAdcModule(ref_pin) != m)) {
+			continue;
+		}
+		if ((ch_pin == ch0_pin) || (ch_pin == ref0_pin) ||
+				(ref_pin == ch0_pin) || (ref_pin == ref0_pin)) {
+			continue;
+		}
+		if (TL_CONFIG(&(bgData[bgChannel(pos)]), sampleType) !=
+				TL_CONFIG(&(bgData[bgChannel(p0)]), sampleType)) {
+			continue;
+		}
 
-	if (d) {
-		delayMicroseconds(d);
+		bgLanePos[1] = pos;
+		bgLaneModule[1] = m;
+		bgNLanes = 2;
+		break;
 	}
 }
+#endif
 
-static void correctSample(struct TLStruct * data, uint8_t nSensors, uint8_t ch)
+static void bgStartConversions(void)
 {
-	TLStruct * d;
-	int32_t tmp, scale;
-	float tmp_f, scale_f;
+	uint8_t lane, ch;
+	uint32_t i;
 
-	d = &(data[ch]);
+	bgNLanesBusy = bgNLanes;
 
-	if (d->tlStructSampleMethod.CVD.nCharges > 1) {
-		/* floating point math */
-		switch (d->filterType) {
-		case TLStruct::filterTypeAverage:
-			scale_f = ((float) (d->nMeasurementsPerSensor << 1)) *
-				((float) (TL_ADC_MAX + 1));
-			break;
-		case TLStruct::filterTypeSlewrateLimiter:
-			scale_f = (float) ((TL_ADC_MAX + 1) << 2);
-			break;
-		case TLStruct::filterTypeMedian:
-			scale_f = (float) ((TL_ADC_MAX + 1) << 2);
-			break;
-		default:
-			/* Error! */
-			scale_f = (float) ((TL_ADC_MAX + 1) << 2);
-		}
-	
-		tmp = 1 - ((float) d->raw) / scale_f;
-
-		tmp_f = pow((float) tmp, -((float) 1) /
-			((float) d->tlStructSampleMethod.CVD.nCharges)) - 
-			((float) 1);
-		tmp_f = (((float) 1) / tmp_f);
-		tmp = (int32_t) tmp_f;
-
-		d->tlStructSampleMethod.CVD.nChargesNext = (int32_t)
-			(ceilf(tmp));
-	
-		tmp = (int32_t) (scale_f * tmp * d->scaleFactor / 
-				d->referenceValue);
-	} else {
-		switch (d->filterType) {
-		case TLStruct::filterTypeAverage:
-			scale = (((int32_t) d->nMeasurementsPerSensor) << 1) *
-				(((int32_t) TL_ADC_MAX) + 1);
-			break;
-		case TLStruct::filterTypeSlewrateLimiter:
-			scale = (((int32_t) TL_ADC_MAX) + 1) << 2;
-			break;
-		case TLStruct::filterTypeMedian:
-			scale = (((int32_t) TL_ADC_MAX) + 1) << 2;
-			break;
-		default:
-			/* Error! */
-			scale = (((int32_t) TL_ADC_MAX) + 1) << 2;
+	for (lane = 0; lane < bgNLanes; lane++) {
+		ch = bgChannel(bgLanePos[lane]);
+		TLSetSensorAndReferencePins(bgSensorFastPin(bgLanePos[lane]),
+			bgReferenceFastPin(bgLanePos[lane]), bgInv);
+
+		/* Set sensor pin as analog input. */
+		TLFastPinInput(bgSensorFastPin(bgLanePos[lane]));
+
+		/* Charges before the conversion, see TLSampleMethodCVDSample() */
+		for (i = 1; i < bgData[ch].tlStructSampleMethodState.CVD.nCharges;
+				i++) {
+			TLCharge(bgData, bgNSensors, ch,
+				bgSensorPin(bgLanePos[lane]),
+				bgReferencePin(bgLanePos[lane]));
 		}
-		tmp = ((d->referenceValue * d->scaleFactor * (scale - d->raw))
-				+ (scale >> 1)) / scale;
 	}
-	d->value = (int32_t) tmp;
 
-	if (d->tlStructSampleMethod.CVD.nChargesNext < 
-			TL_N_CHARGES_MIN_DEFAULT) {
-		d->tlStructSampleMethod.CVD.nChargesNext =
-			TL_N_CHARGES_MIN_DEFAULT;
+	for (lane = 0; lane < bgNLanes; lane++) {
+		/* Set ADC to reference pin (charge internal capacitor). */
+		ch = bgChannel(bgLanePos[lane]);
+		TLChargeADC(bgData, bgNSensors, ch,
+			bgReferencePin(bgLanePos[lane]), true);
 	}
-	if (d->tlStructSampleMethod.CVD.nChargesNext > 
-			TL_N_CHARGES_MAX_DEFAULT) {
-		d->tlStructSampleMethod.CVD.nChargesNext =
-			TL_N_CHARGES_MAX_DEFAULT;
+
+	/* Start conversions; completion calls back into this file. */
+	for (lane = 0; lane < bgNLanes; lane++) {
+		TLAdcStartConversion(bgSensorPin(bgLanePos[lane]));
 	}
-	/* Capacitance can be negative due to noise! */
 }
 
-static void updateNCharges(struct TLStruct * data, uint8_t nSensors, uint8_t ch)
+static void bgStartGroup(void)
 {
-	TLStruct * d;
+	bgLanePos[0] = bgNext;
+	bgLaneModule[0] = 0;
+	bgNLanes = 1;
 
-	d = &(data[ch]);
-	d->tlStructSampleMethod.CVD.nCharges = d->tlStructSampleMethod.CVD.nChargesNext;
-}
+	#if (TL_ADC_N_MODULES > 1)
+	bgFindPartner();
+	#endif
 
+	bgInv = !(TL_CONFIG(&(bgData[bgChannel(bgNext)]), sampleType) &
+		TLStruct::sampleTypeNormal);
 
-int TLSampleMethodCVDPreSample(struct TLStruct * data, uint8_t nSensors,
-		uint8_t ch)
-{
-	return 0;
+	bgStartConversions();
 }
 
-int32_t TLSampleMethodCVDSample(struct TLStruct * data, uint8_t nSensors, 
-		uint8_t ch, bool inv)
+void TLSampleMethodCVDConversionComplete(int8_t module, int value)
 {
-	struct TLStruct * dCh;
-	struct TLStruct * dRef;
-	uint8_t ref;
-	int ch_pin, ref_pin;
-	int32_t sample;
-	uint8_t i;
+	uint8_t lane = 0, ch;
+	uint16_t pos;
+	uint32_t i, nChargesMax;
 
-	ref = TLChannelToReference(data, nSensors, ch);
-	if (ref == 0xFF) {
-		/* An error occurred! */
-		return 0;
+	if (!bgBusy) {
+		return;
 	}
 
-	dCh = &(data[ch]);
-	dRef = &(data[ref]);
-	ch_pin = dCh->tlStructSampleMethod.CVD.pin;
-	ref_pin = dRef->tlStructSampleMethod.CVD.pin;
+	if ((bgNLanes > 1) && (bgLaneModule[1] == module)) {
+		lane = 1;
+	}
+	pos = bgLanePos[lane];
+	ch = bgChannel(pos);
 
-	if (ch_pin < 0) {
-		/* An error occurred! */
-		return 0;
+	if (bgInv) {
+		value = TL_ADC_MAX - value;
+	}
+	bgResults[2 * pos + (bgInv ? 1 : 0)] = value;
+
+	if (TL_CONFIG(&(bgData[ch]),
+			tlStructSampleMethod.CVD.useNChargesPadding)) {
+		nChargesMax = TL_CONFIG(&(bgData[ch]),
+			tlStructSampleMethod.CVD.nChargesMax);
+		for (i = bgData[ch].tlStructSampleMethodState.CVD.nCharges;
+				i < nChargesMax; i++) {
+			TLCharge(bgData, bgNSensors, ch, bgSensorPin(pos),
+				bgReferencePin(pos));
+		}
 	}
 
-	if (ref_pin < 0) {
-		/* An error occurred! */
-		return 0;
+	TLDischargeSensor(bgData, bgNSensors, ch, true);
+
+	if (--bgNLanesBusy > 0) {
+		/* Wait for other ADC module */
+		return;
 	}
 
-	TLSetSensorAndReferencePins(ch_pin, ref_pin, inv);
+	if ((!bgInv) && (TL_CONFIG(&(bgData[bgChannel(bgNext)]), sampleType) &
+			TLStruct::sampleTypeInverted)) {
+		bgInv = true;
+		bgStartConversions();
+		return;
+	}
 
-	/* Set sensor pin as analog input. */
-	pinMode(ch_pin, INPUT);
+	/* Group is finished */
+	if (bgNLanes > 1) {
+		bgAhead |= 1 << (bgLanePos[1] - bgNext - 1);
+	}
+	bgAdvance();
 
-	/*
-	 * Charge nCharges - 1 times to account for the charge during the
-	 * TLAnalogRead() below.
-	 */
-	for (i = 0; i < dCh->tlStructSampleMethod.CVD.nCharges - 1; i++) {
-		TLCharge(data, nSensors, ch, ch_pin, ref_pin);
+	if (bgNext >= bgLength) {
+		bgBusy = false;
+		TLAdcStopConversions();
+		return;
 	}
 
-	/* Set ADC to reference pin (charge internal capacitor). */
-	TLChargeADC(data, nSensors, ch, ref_pin, true);
+	bgStartGroup();
+}
+#endif
 
-	/* Read sensor. */
-	sample = TLAnalogRead(ch_pin);
+int TLSampleMethodCVDBackgroundStart(struct TLStruct * data, uint8_t nSensors,
+		const uint8_t * scanOrder, bool scanOrderInFlash, uint16_t length,
+		uint16_t * results)
+{
+	#if defined(TL_METHOD_CVD_BACKGROUND_SUPPORTED)
+	struct TLStruct * d;
+	uint8_t ch, ref;
+
+	TLSampleMethodCVDBackgroundStop();
+	/* Also discards conversions the board code may consider pending */
+	TLAdcStopConversions();
 
-	if (inv) {
-		sample = TL_ADC_MAX - sample;
+	if (length == 0) {
+		return -1;
 	}
 
-	if (dCh->tlStructSampleMethod.CVD.useNChargesPadding) {
-		/*
-		 * Increment i before starting the loop to account for the
-		 * charge during the TLAnalogRead() above.
-		 */
-		for (++i; i < dCh->tlStructSampleMethod.CVD.nChargesMax; i++) {
-			TLCharge(data, nSensors, ch, ch_pin, ref_pin);
+	for (ch = 0; ch < nSensors; ch++) {
+		d = &(data[ch]);
+		if ((TL_CONFIG(d, sampleMethodSample) !=
+				TLSampleMethodCVDSample) ||
+				(TL_CONFIG(d, waterRejectPin) >= 0) ||
+				(TL_CONFIG(d, sampleType) == 0) ||
+				(TL_CONFIG(d, tlStructSampleMethod.CVD.pin) < 0)) {
+			return -1;
 		}
+		ref = TLChannelToReference(data, nSensors, ch);
+		if ((ref == 0xFF) || (TL_CONFIG(&(data[ref]),
+				tlStructSampleMethod.CVD.pin) < 0)) {
+			return -1;
+		}
+		TLFastPinUpdate(&(d->tlStructSampleMethodState.CVD.fastPin),
+			TL_CONFIG(d, tlStructSampleMethod.CVD.pin));
+	}
+
+	bgData = data;
+	bgNSensors = nSensors;
+	bgScanOrder = scanOrder;
+	bgScanOrderInFlash = scanOrderInFlash;
+	bgLength = length;
+	bgResults = results;
+	bgNext = 0;
+	bgAhead = 0;
+	if (bgSkipped(0)) {
+		bgAdvance();
+	}
+	if (bgNext >= bgLength) {
+		/* Nothing to measure */
+		return 0;
 	}
+	bgBusy = true;
 
-	TLDischargeSensor(data, nSensors, ch, true);
+	bgStartGroup();
 
-	return sample;
+	return 0;
+	#else
+	return -1;
+	#endif
 }
 
-int TLSampleMethodCVDPostSample(struct TLStruct * data, uint8_t nSensors,
-		uint8_t ch)
+uint16_t TLSampleMethodCVDBackgroundProgress(void)
 {
-	correctSample(data, nSensors, ch);
-	updateNCharges(data, nSensors, ch);
+	#if defined(TL_METHOD_CVD_BACKGROUND_SUPPORTED)
+	uint16_t a, b;
+
+	TLAdcPoll();
 
+	/* 16 bit reads are not atomic on 8 bit processors; read until stable */
+	do {
+		a = bgNext;
+		b = bgNext;
+	} while (a != b);
+
+	return a;
+	#else
 	return 0;
+	#endif
+}
+
+void TLSampleMethodCVDBackgroundStop(void)
+{
+	#if defined(TL_METHOD_CVD_BACKGROUND_SUPPORTED)
+	uint8_t lane;
+
+	if (bgBusy) {
+		TLAdcStopConversions();
+		bgBusy = false;
+
+		/* Leave sensors that were being measured discharged */
+		for (lane = 0; lane < bgNLanes; lane++) {
+			TLDischargeSensor(bgData, bgNSensors,
+				bgChannel(bgLanePos[lane]), false);
+		}
+	}
+	#endif
+}
+
+int TLSampleMethodCVDPreSample(struct TLStruct * data, uint8_t nSensors,
+		uint8_t ch)
+{
+	return TLSampleMethodCVDPolicy::preSample(data, nSensors, ch);
+}
+
+int32_t TLSampleMethodCVDSample(struct TLStruct * data, uint8_t nSensors, 
+		uint8_t ch, bool inv)
+{
+	return TLSampleMethodCVDPolicy::sample(data, nSensors, ch, inv);
+}
+
+int TLSampleMethodCVDPostSample(struct TLStruct * data, uint8_t nSensors,
+		uint8_t ch)
+{
+	return TLSampleMethodCVDPolicy::postSample(data, nSensors, ch,
+		TL_CONFIG(&(data[ch]), filterType));
 }
 
 int32_t TLSampleMethodCVDMapDelta(struct TLStruct * data, uint8_t nSensors,
@@ -330,20 +468,26 @@ int32_t TLSampleMethodCVDMapDelta(struct TLStruct * data, uint8_t nSensors,
 {
 	int32_t n = -1;
 	struct TLStruct * d;
-	int32_t delta;
+	int32_t delta, calibratedMaxDelta;
 
 	d = &(data[ch]);
 
 	delta = d->delta;
 
+	calibratedMaxDelta = TL_CONFIG(d, calibratedMaxDelta);
+	if ((delta <= 0) || (calibratedMaxDelta <= 1)) {
+		return 0;
+	}
+
 	/*
 	 * Ignore everything below TL_BAR_LOWER_PCT of log(maxDelta); it's
-	 * mostly noise
+	 * mostly noise. Logarithms are in Q8 format to prevent overflow in
+	 * map().
 	 */
-	n = map(100 * log(delta), TL_BAR_LOWER_PCT * 
-		log(d->calibratedMaxDelta),
-		TL_BAR_UPPER_PCT * log(d->calibratedMaxDelta), (float) 0,
-		(float) length);
+	n = map(100 * (TLLog2Q16(delta) >> 8), TL_BAR_LOWER_PCT *
+		(TLLog2Q16(calibratedMaxDelta) >> 8),
+		TL_BAR_UPPER_PCT * (TLLog2Q16(calibratedMaxDelta) >> 8), 0,
+		length);
 
 	n = (n < 0) ? 0 : n;
 	n = (n > length) ? length : n;
@@ -351,9 +495,24 @@ int32_t TLSampleMethodCVDMapDelta(struct TLStruct * data, uint8_t nSensors,
 	return n;
 }
 
+void TLSampleMethodCVDResetState(struct TLStruct * d)
+{
+	struct TLStructSampleMethodCVDState * c;
+
+	c = &(d->tlStructSampleMethodState.CVD);
+
+	TLFastPinInit(&(c->fastPin),
+		TL_CONFIG(d, tlStructSampleMethod.CVD.pin));
+	c->nCharges = TL_CONFIG(d, tlStructSampleMethod.CVD.nChargesMin);
+	c->nChargesNext = c->nCharges;
+	c->referenceChannelCache = TL_REFERENCE_CHANNEL_CACHE_INVALID;
+}
+
 int TLSampleMethodCVD(struct TLStruct * data, uint8_t nSensors, uint8_t ch)
 {
 	struct TLStruct * d;
+	struct TLStructConfig * c;
+	struct TLStructConfig m;
 
 	#if defined(__MK64FX512__) || defined(__MK66FX1M0__)
 	/* Perform analogRead() to ensure ADC has finished calibration */
@@ -362,46 +521,15 @@ int TLSampleMethodCVD(struct TLStruct * data, uint8_t nSensors, uint8_t ch)
 
 	d = &(data[ch]);
 
-	d->sampleMethodPreSample = TLSampleMethodCVDPreSample;
-	d->sampleMethodSample = TLSampleMethodCVDSample;
-	d->sampleMethodPostSample = TLSampleMethodCVDPostSample;
-	d->sampleMethodMapDelta = TLSampleMethodCVDMapDelta;
-
-	d->tlStructSampleMethod.CVD.pin = A0 + ch;
-	d->tlStructSampleMethod.CVD.useNChargesPadding =
-		TL_USE_N_CHARGES_PADDING_DEFAULT;
-	d->tlStructSampleMethod.CVD.nChargesMin = TL_N_CHARGES_MIN_DEFAULT;
-	d->tlStructSampleMethod.CVD.nChargesMax = TL_N_CHARGES_MAX_DEFAULT;
-	d->tlStructSampleMethod.CVD.nCharges = TL_N_CHARGES_MIN_DEFAULT;
-	d->tlStructSampleMethod.CVD.nChargesNext = TL_N_CHARGES_MIN_DEFAULT;
-
-	d->tlStructSampleMethod.CVD.chargeDelaySensor =
-		TL_CHARGE_DELAY_SENSOR_DEFAULT;
-
-	d->tlStructSampleMethod.CVD.chargeDelayADC = TL_CHARGE_DELAY_ADC_DEFAULT;
-
-	d->referenceValue = TL_REFERENCE_VALUE_DEFAULT;
-	d->offsetValue = TL_OFFSET_VALUE_DEFAULT;
-	d->scaleFactor = TL_SCALE_FACTOR_DEFAULT;
-	d->setOffsetValueManually = TL_SET_OFFSET_VALUE_MANUALLY_DEFAULT;
-
-	d->releasedToApproachedThreshold = 
-		TL_RELEASED_TO_APPROACHED_THRESHOLD_DEFAULT;
-	d->approachedToReleasedThreshold =
-		TL_APPROACHED_TO_RELEASED_THRESHOLD_DEFAULT;
-	d->approachedToPressedThreshold =
-		TL_APPROACHED_TO_PRESSED_THRESHOLD_DEFAULT;     
-	d->pressedToApproachedThreshold =
-		TL_PRESSED_TO_APPROACHED_THRESHOLD_DEFAULT; 
-
-	d->direction = TLStruct::directionPositive;
-	d->sampleType = TLStruct::sampleTypeDifferential;
-	d->filterType = TLStruct::filterTypeAverage;
-	d->waterRejectPin = -1;
-	d->waterRejectMode = TLStruct::waterRejectModeFloat;
-
-	d->pin = &(d->tlStructSampleMethod.CVD.pin);
+	/* A const configuration is used as is */
+	c = TLConfigWritable(d);
+	if (c != NULL) {
+		m = TLSampleMethodCVDConfig(A0 + ch);
+		TLConfigSetSampleMethod(c, &m);
+	}
+
+	TLSampleMethodCVDResetState(d);
+	d->offsetValue = TL_CVD_OFFSET_VALUE_DEFAULT;
 
 	return 0;
 }
-
@@ -32,20 +32,39 @@
 #define TLSampleMethodCVD_h
 
 #include <TouchLib.h>
+#include <TLFastGpio.h>
 
 struct TLStructSampleMethodCVD {
         int pin;
 	bool useNChargesPadding;
 	uint32_t nChargesMin;
 	uint32_t nChargesMax;
-	uint32_t nCharges;
-	uint32_t nChargesNext;
 
 	/* delay to charge sensor in microseconds (us) */
 	unsigned int chargeDelaySensor;
 
 	/* delay to charge ADC in microseconds (us) */
         unsigned int chargeDelayADC; 
+
+	/*
+	 * Channel of which the pin is used as reference for this sensor. The
+	 * reference channel must use TLSampleMethodCVD as well. Default is -1,
+	 * which selects the next channel that uses TLSampleMethodCVD.
+	 */
+	int referenceChannel;
+};
+
+/* Runtime state of a CVD sensor; maintained by the library */
+struct TLStructSampleMethodCVDState {
+	struct TLFastPin fastPin; /* registers of pin */
+	uint32_t nCharges;
+	uint32_t nChargesNext;
+
+	/*
+	 * Reference channel found for referenceChannel == -1; see
+	 * TLSampleMethodCVDInvalidateReferences().
+	 */
+	uint8_t referenceChannelCache;
 };
 
 int TLSampleMethodCVDPreSample(struct TLStruct * data, uint8_t nSensors,
@@ -62,4 +81,57 @@ int32_t TLSampleMethodCVDMapDelta(struct TLStruct * d, uint8_t nSensors,
 
 int TLSampleMethodCVD(struct TLStruct * data, uint8_t nSensors, uint8_t ch);
 
+/*
+ * Initialize the runtime state of sensor d from its configuration. Called by
+ * TLSampleMethodCVD() and when the configuration of a sensor is replaced (see
+ * TLSensors::setConfig()).
+ */
+void TLSampleMethodCVDResetState(struct TLStruct * d);
+
+/*
+ * Forget the cached reference channels of all sensors. Must be called when the
+ * sample method of any sensor changes; TLSensors::initialize() and
+ * TLSensors::setConfig() do this.
+ */
+void TLSampleMethodCVDInvalidateReferences(struct TLStruct * data,
+		uint8_t nSensors);
+
+/*
+ * Background scanning. TLSampleMethodCVDBackgroundStart() starts the
+ * conversions for all length positions in scanOrder. Set scanOrderInFlash if
+ * scanOrder is stored with TL_SCAN_ORDER_ATTR (see TLScanOrder.h). Conversions
+ * are chained by the ADC conversion complete interrupt(s); on boards with two
+ * ADC modules two positions are measured simultaneously. Results are written
+ * to results, which must hold 2 * length values: results[2 * pos] is the
+ * normal and results[2 * pos + 1] the inverted measurement of position pos.
+ * Returns 0 on success or -1 if background scanning is not supported by the
+ * board or by the configuration of the sensors (all sensors must use
+ * TLSampleMethodCVD without water reject pin), in which case nothing is
+ * started. Charges before and after the conversion (nCharges > 1) are done
+ * from the interrupt.
+ *
+ * Positions pos for which results[2 * pos] is TL_BACKGROUND_POSITION_SKIPPED
+ * when TLSampleMethodCVDBackgroundStart() is called are not measured; their
+ * results are left unchanged. Conversion results are at most TL_ADC_MAX, which
+ * is smaller on all supported boards.
+ *
+ * TLSampleMethodCVDBackgroundProgress() returns the number of positions for
+ * which all conversions have finished (skipped positions included).
+ */
+#define TL_BACKGROUND_POSITION_SKIPPED			0xFFFF
+
+int TLSampleMethodCVDBackgroundStart(struct TLStruct * data, uint8_t nSensors,
+		const uint8_t * scanOrder, bool scanOrderInFlash, uint16_t length,
+		uint16_t * results);
+
+uint16_t TLSampleMethodCVDBackgroundProgress(void);
+
+void TLSampleMethodCVDBackgroundStop(void);
+
+/*
+ * Called by the board specific code when a background conversion on ADC module
+ * module (0 on boards with a single ADC) finishes.
+ */
+void TLSampleMethodCVDConversionComplete(int8_t module, int value);
+
 #endif
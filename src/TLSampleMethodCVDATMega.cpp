@@ -35,6 +35,8 @@
 
 #if IS_ATMEGA
 
+#include <avr/interrupt.h>
+
 #define TL_N_CHARGES_MIN_DEFAULT			1
 #define TL_N_CHARGES_MAX_DEFAULT			1
 
@@ -87,4 +89,42 @@ int TLAnalogRead(int pin)
 	return analogRead(pin - A0);
 }
 
+#if defined(TL_METHOD_CVD_BACKGROUND_SUPPORTED)
+/*
+ * Start a conversion of pin without waiting for it. The ADC conversion
+ * complete interrupt passes the result to TLSampleMethodCVDConversionComplete(),
+ * which sets up and starts the next conversion. This frees the CPU during the
+ * ~104 us of each conversion that analogRead() spends busy waiting.
+ *
+ * Only built with TL_ENABLE_ADC_ISR, as this defines the ADC_vect interrupt
+ * handler; sketches can then not define their own.
+ */
+void TLAdcStartConversion(int pin)
+{
+	TLSetAdcReferencePin(pin);
+
+	/* Use AVcc as reference, like analogRead() does by default */
+	ADMUX = (ADMUX & ~((1 << REFS1) | (1 << REFS0))) | (1 << REFS0);
+
+	/* Clear pending interrupt flag, enable interrupt and start */
+	ADCSRA |= (1 << ADIF);
+	ADCSRA |= (1 << ADIE) | (1 << ADSC);
+}
+
+void TLAdcStopConversions(void)
+{
+	ADCSRA &= ~(1 << ADIE);
+}
+
+void TLAdcPoll(void)
+{
+	/* Conversions are handled by the interrupt; nothing to do */
+}
+
+ISR(ADC_vect)
+{
+	TLSampleMethodCVDConversionComplete(0, ADC);
+}
+#endif
+
 #endif
@@ -28,7 +28,7 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifndef TLSampleMethodCVDATMega
+#ifndef TLSampleMethodCVDATMega_h
 #define TLSampleMethodCVDATMega_h
 
 #include <stdint.h>
@@ -51,8 +51,21 @@
 
 #define TL_METHOD_CVD_SUPPORTED
 
+/*
+ * Background scanning chains conversions from the ADC_vect interrupt handler,
+ * which TouchLib then defines. A vector can only have one handler, so this is
+ * only done if TL_ENABLE_ADC_ISR is defined for the library build (e.g. in the
+ * compiler flags); it is not enough to define it in the sketch.
+ */
+#if defined(TL_ENABLE_ADC_ISR)
+#define TL_METHOD_CVD_BACKGROUND_SUPPORTED
+#endif
+
 extern void TLSetAdcReferencePin(int pin);
 extern int TLAnalogRead(int pin);
+extern void TLAdcStartConversion(int pin);
+extern void TLAdcStopConversions(void);
+extern void TLAdcPoll(void);
 
 #endif
 
@@ -28,7 +28,7 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifndef TLSampleMethodCVDEsp32
+#ifndef TLSampleMethodCVDEsp32_h
 #define TLSampleMethodCVDEsp32_h
 
 #include <stdint.h>
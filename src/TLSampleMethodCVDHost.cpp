@@ -0,0 +1,100 @@
+/*
+ * TLSampleMethodCVDHost.cpp - Capacitive sensing library based on TL method for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include "TouchLib.h"
+#include "TLSampleMethodCVDHost.h"
+#include "BoardID.h"
+
+#if IS_HOST
+
+void TLSetAdcReferencePin(int pin)
+{
+	/* Simulated ADC multiplexer; see TLHost.cpp */
+	TLHostSetAdcMux(pin);
+}
+
+int TLAnalogRead(int pin)
+{
+	return analogRead(pin);
+}
+
+/*
+ * There are no interrupts on the host. A started conversion stays pending
+ * until TLAdcPoll() is called, which then completes it (and all conversions
+ * that are started as a result of that). A pin of -1 means no conversion is
+ * pending; TLSampleMethodCVDBackgroundStart() clears pendingPin with
+ * TLAdcStopConversions() before the first conversion is started.
+ */
+static int pendingPin[TL_ADC_N_MODULES];
+
+int8_t TLAdcModule(int pin)
+{
+	return TLHostAdcModule(pin);
+}
+
+void TLAdcStartConversion(int pin)
+{
+	int8_t m = TLAdcModule(pin);
+
+	if (m >= 0) {
+		TLHostSetAdcMux(pin);
+		pendingPin[m] = pin;
+	}
+}
+
+void TLAdcStopConversions(void)
+{
+	int8_t m;
+
+	for (m = 0; m < TL_ADC_N_MODULES; m++) {
+		pendingPin[m] = -1;
+	}
+}
+
+void TLAdcPoll(void)
+{
+	int8_t m;
+	int pin;
+	bool pending;
+
+	do {
+		pending = false;
+		for (m = 0; m < TL_ADC_N_MODULES; m++) {
+			pin = pendingPin[m];
+			if (pin >= 0) {
+				pendingPin[m] = -1;
+				pending = true;
+				TLSampleMethodCVDConversionComplete(m,
+					analogRead(pin));
+			}
+		}
+	} while (pending);
+}
+
+#endif
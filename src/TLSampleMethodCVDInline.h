@@ -0,0 +1,462 @@
+/*
+ * TLSampleMethodCVDInline.h - Inline parts of the CVD method for TouchLibrary
+ * for Arduino
+ *
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016 - 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TLSampleMethodCVDInline_h
+#define TLSampleMethodCVDInline_h
+
+/*
+ * Measurement and sample correction of the CVD method. These are inline so that
+ * TLSensorsStatic can call them directly from its scan loop; the functions in
+ * TLSampleMethodCVD.cpp use the same code. Included by TouchLib.h after struct
+ * TLStructConfig.
+ */
+
+#include <stdint.h>
+#include "BoardID.h"
+#include "TLFastGpio.h"
+#include "TLFixedPoint.h"
+
+#if IS_ATMEGA
+#include "TLSampleMethodCVDATMega.h"
+#elif IS_TEENSY3X
+#include "TLSampleMethodCVDTeensy3x.h"
+#elif IS_PARTICLE
+#include "TLSampleMethodCVDParticle.h"
+#elif IS_ESP32
+#include "TLSampleMethodCVDEsp32.h"
+#elif IS_HOST
+#include "TLSampleMethodCVDHost.h"
+#endif
+
+#ifndef TL_METHOD_CVD_SUPPORTED
+#include "TLSampleMethodCVDUnsupported.h"
+#endif
+
+#define TL_CVD_USE_N_CHARGES_PADDING_DEFAULT		true
+
+#define TL_CVD_REFERENCE_VALUE_DEFAULT			((int32_t) 15000) /* 15 pF */
+#define TL_CVD_SCALE_FACTOR_DEFAULT			((int32_t) 1)
+#define TL_CVD_OFFSET_VALUE_DEFAULT			((int32_t) 1000000) /* fF */
+
+#define TL_CVD_RELEASED_TO_APPROACHED_THRESHOLD_DEFAULT	((int32_t) 5)
+#define TL_CVD_APPROACHED_TO_RELEASED_THRESHOLD_DEFAULT	((int32_t) 4)
+#define TL_CVD_APPROACHED_TO_PRESSED_THRESHOLD_DEFAULT	((int32_t) 10)
+#define TL_CVD_PRESSED_TO_APPROACHED_THRESHOLD_DEFAULT	((int32_t) 80)
+
+#define TL_CVD_REFERENCE_CHANNEL_DEFAULT		-1
+
+/*
+ * Configuration of a CVD sensor on pin with the defaults of the library, for
+ * constant initializers of configurations (see TLSensors::setConfig()). This is
+ * the configuration that TLSampleMethodCVD() sets, apart from the pin.
+ */
+constexpr struct TLStructConfig TLSampleMethodCVDConfig(int pin,
+		int32_t releasedToApproachedThreshold =
+		TL_CVD_RELEASED_TO_APPROACHED_THRESHOLD_DEFAULT,
+		int32_t approachedToReleasedThreshold =
+		TL_CVD_APPROACHED_TO_RELEASED_THRESHOLD_DEFAULT,
+		int32_t approachedToPressedThreshold =
+		TL_CVD_APPROACHED_TO_PRESSED_THRESHOLD_DEFAULT,
+		int32_t pressedToApproachedThreshold =
+		TL_CVD_PRESSED_TO_APPROACHED_THRESHOLD_DEFAULT)
+{
+	return TLStructConfigMake(TLStructSampleMethodCVD {
+			pin,
+			TL_CVD_USE_N_CHARGES_PADDING_DEFAULT,
+			TL_N_CHARGES_MIN_DEFAULT,
+			TL_N_CHARGES_MAX_DEFAULT,
+			TL_CHARGE_DELAY_SENSOR_DEFAULT,
+			TL_CHARGE_DELAY_ADC_DEFAULT,
+			TL_CVD_REFERENCE_CHANNEL_DEFAULT
+		}, TLSampleMethodCVD, TLSampleMethodCVDPreSample,
+		TLSampleMethodCVDSample, TLSampleMethodCVDPostSample,
+		TLSampleMethodCVDMapDelta, TL_CVD_REFERENCE_VALUE_DEFAULT,
+		TL_CVD_SCALE_FACTOR_DEFAULT, releasedToApproachedThreshold,
+		approachedToReleasedThreshold, approachedToPressedThreshold,
+		pressedToApproachedThreshold, TLStruct::directionPositive,
+		TLStruct::sampleTypeDifferential);
+}
+
+/* Value of referenceChannelCache if reference must be searched again */
+#define TL_REFERENCE_CHANNEL_CACHE_INVALID		0xFE
+
+uint8_t TLFindReference(struct TLStruct * data, uint8_t nSensors, uint8_t ch);
+
+static inline uint8_t TLChannelToReference(struct TLStruct * data,
+		uint8_t nSensors, uint8_t ch)
+{
+	struct TLStructSampleMethodCVDState * c;
+	int ref;
+
+	c = &(data[ch].tlStructSampleMethodState.CVD);
+	ref = TL_CONFIG(&(data[ch]), tlStructSampleMethod.CVD.referenceChannel);
+
+	if (ref >= 0) {
+		/* Reference specified by user */
+		if ((ref >= nSensors) || (ref == ch) ||
+				(TL_CONFIG(&(data[ref]), sampleMethod) !=
+				TLSampleMethodCVD)) {
+			/* Error! Invalid reference channel. */
+			return 0xFF;
+		}
+		return ref;
+	}
+
+	if (c->referenceChannelCache == TL_REFERENCE_CHANNEL_CACHE_INVALID) {
+		c->referenceChannelCache = TLFindReference(data, nSensors, ch);
+	}
+
+	return c->referenceChannelCache;
+}
+
+static inline void TLSetSensorAndReferencePins(struct TLFastPin * ch_pin,
+		struct TLFastPin * ref_pin, bool inv)
+{
+	/* Set reference pin as output and high. */
+
+	TLFastPinOutput(ref_pin);
+	if (inv) {
+		TLFastPinLow(ref_pin);
+	} else {
+		TLFastPinHigh(ref_pin);
+	}
+
+	/* Set sensor pin as output and low (discharge sensor). */
+	TLFastPinOutput(ch_pin);
+	if (inv) {
+		TLFastPinHigh(ch_pin);
+	} else {
+		TLFastPinLow(ch_pin);
+	}
+}
+
+static inline void TLChargeADC(struct TLStruct * data, uint8_t nSensors,
+		uint8_t ch, int ref_pin, bool delay)
+{
+	unsigned int d;
+
+	/* Set ADC to reference pin (charge Chold). */
+	TLSetAdcReferencePin(ref_pin);
+
+	d = TL_CONFIG(&(data[ch]), tlStructSampleMethod.CVD.chargeDelayADC);
+	if ((delay) && (d)) {
+		delayMicroseconds(d);
+	}
+}
+
+static inline void TLChargeSensor(struct TLStruct * data, uint8_t nSensors,
+		uint8_t ch, int ch_pin, bool delay)
+{
+	unsigned int d;
+
+	/*
+	 * Set ADC to sensor pin (transfer charge from Chold to Csense).
+	 */
+	TLSetAdcReferencePin(ch_pin);
+
+	d = TL_CONFIG(&(data[ch]), tlStructSampleMethod.CVD.chargeDelaySensor);
+	if ((delay) && (d)) {
+		delayMicroseconds(d);
+	}
+}
+
+static inline void TLDischargeSensor(struct TLStruct * data, uint8_t nSensors,
+		uint8_t ch, bool delay)
+{
+	unsigned int d;
+
+	TLFastPinOutput(&(data[ch].tlStructSampleMethodState.CVD.fastPin));
+	TLFastPinLow(&(data[ch].tlStructSampleMethodState.CVD.fastPin));
+
+	d = TL_CONFIG(&(data[ch]), tlStructSampleMethod.CVD.chargeDelaySensor);
+	if ((delay) && (d)) {
+		delayMicroseconds(d);
+	}
+}
+
+static inline void TLCharge(struct TLStruct * data, uint8_t nSensors,
+		uint8_t ch, int ch_pin, int ref_pin)
+{
+	unsigned int d, dSensor;
+
+	TLChargeADC(data, nSensors, ch, ref_pin, false);
+	TLChargeSensor(data, nSensors, ch, ch_pin, false);
+
+	d = TL_CONFIG(&(data[ch]), tlStructSampleMethod.CVD.chargeDelayADC);
+	dSensor = TL_CONFIG(&(data[ch]),
+		tlStructSampleMethod.CVD.chargeDelaySensor);
+	d = (d > dSensor) ? d : dSensor;
+
+	if (d) {
+		delayMicroseconds(d);
+	}
+}
+
+/*
+ * Sample method policy for TLSensorsStatic. TLSampleMethodCVDPreSample(),
+ * TLSampleMethodCVDSample() and TLSampleMethodCVDPostSample() call these
+ * functions as well. postSample() takes the filter type as a template
+ * argument, so that the scale of raw is a constant.
+ */
+struct TLSampleMethodCVDPolicy {
+	/* Sample method to pass to TLSensors::initialize() */
+	static int (*sampleMethod(void))(struct TLStruct * data,
+			uint8_t nSensors, uint8_t ch)
+	{
+		return TLSampleMethodCVD;
+	}
+
+	static int preSample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch)
+	{
+		#if defined(TL_METHOD_CVD_ADC_SESSION)
+		/* Configure ADC once for all conversions of this scan */
+		TLAdcSessionBegin();
+		#endif
+
+		return 0;
+	}
+
+	static int32_t sample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch, bool inv)
+	{
+		struct TLStruct * dCh;
+		struct TLStruct * dRef;
+		uint8_t ref;
+		int ch_pin, ref_pin;
+		int32_t sample;
+		uint32_t nChargesMax;
+		uint8_t i;
+
+		ref = TLChannelToReference(data, nSensors, ch);
+		if (ref == 0xFF) {
+			/* An error occurred! */
+			return 0;
+		}
+
+		dCh = &(data[ch]);
+		dRef = &(data[ref]);
+		ch_pin = TL_CONFIG(dCh, tlStructSampleMethod.CVD.pin);
+		ref_pin = TL_CONFIG(dRef, tlStructSampleMethod.CVD.pin);
+
+		if (ch_pin < 0) {
+			/* An error occurred! */
+			return 0;
+		}
+
+		if (ref_pin < 0) {
+			/* An error occurred! */
+			return 0;
+		}
+
+		TLFastPinUpdate(&(dCh->tlStructSampleMethodState.CVD.fastPin),
+			ch_pin);
+		TLFastPinUpdate(&(dRef->tlStructSampleMethodState.CVD.fastPin),
+			ref_pin);
+
+		TLSetSensorAndReferencePins(
+			&(dCh->tlStructSampleMethodState.CVD.fastPin),
+			&(dRef->tlStructSampleMethodState.CVD.fastPin), inv);
+
+		/* Set sensor pin as analog input. */
+		TLFastPinInput(&(dCh->tlStructSampleMethodState.CVD.fastPin));
+
+		/*
+		 * Charge nCharges - 1 times to account for the charge during
+		 * the TLAnalogRead() below.
+		 */
+		for (i = 0; i < dCh->tlStructSampleMethodState.CVD.nCharges - 1;
+				i++) {
+			TLCharge(data, nSensors, ch, ch_pin, ref_pin);
+		}
+
+		/* Set ADC to reference pin (charge internal capacitor). */
+		TLChargeADC(data, nSensors, ch, ref_pin, true);
+
+		/* Read sensor. */
+		sample = TLAnalogRead(ch_pin);
+
+		if (inv) {
+			sample = TL_ADC_MAX - sample;
+		}
+
+		if (TL_CONFIG(dCh,
+				tlStructSampleMethod.CVD.useNChargesPadding)) {
+			/*
+			 * Increment i before starting the loop to account for
+			 * the charge during the TLAnalogRead() above.
+			 */
+			nChargesMax = TL_CONFIG(dCh,
+				tlStructSampleMethod.CVD.nChargesMax);
+			for (++i; i < nChargesMax; i++) {
+				TLCharge(data, nSensors, ch, ch_pin, ref_pin);
+			}
+		}
+
+		TLDischargeSensor(data, nSensors, ch, true);
+
+		return sample;
+	}
+
+	/* Full scale of raw for filterType */
+	static int32_t rawScale(enum TLStruct::FilterType filterType,
+			uint8_t nMeasurementsPerSensor)
+	{
+		switch (filterType) {
+		case TLStruct::filterTypeAverage:
+		case TLStruct::filterTypeIIR:
+		case TLStruct::filterTypeMedian3:
+		case TLStruct::filterTypeTrimmedMean:
+			/*
+			 * Raw is scaled to the sum of nMeasurementsPerSensor
+			 * samples
+			 */
+			return (((int32_t) nMeasurementsPerSensor) << 1) *
+				(((int32_t) TL_ADC_MAX) + 1);
+		case TLStruct::filterTypeSlewrateLimiter:
+			return (((int32_t) TL_ADC_MAX) + 1) << 2;
+		case TLStruct::filterTypeMedian:
+			return (((int32_t) TL_ADC_MAX) + 1) << 2;
+		default:
+			/* Error! */
+			return (((int32_t) TL_ADC_MAX) + 1) << 2;
+		}
+	}
+
+	static void correctSample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch, int32_t scale)
+	{
+		TLStruct * d;
+		int32_t tmp, raw;
+		uint32_t u, v;
+
+		d = &(data[ch]);
+
+		if (d->tlStructSampleMethodState.CVD.nCharges > 1) {
+			/*
+			 * After n charges, the fraction 1 - raw / scale of the
+			 * charge is left on the sensor, where:
+			 *   1 - raw / scale = pow(Ch / (Ch + Cs), n)
+			 * with Ch the ADC hold capacitance and Cs the sensor
+			 * capacitance. Solving for ratio = Cs / Ch gives:
+			 *   ratio = 1 / (pow(scale / (scale - raw), 1 / n) - 1)
+			 * which is computed in fixed point math (Q16 format).
+			 */
+			raw = d->raw;
+			if (raw < 0) {
+				raw = 0;
+			}
+			if (raw > scale - 1) {
+				raw = scale - 1;
+			}
+			while (scale > 0xFFFF) {
+				scale = scale >> 1;
+				raw = raw >> 1;
+			}
+
+			/* u = scale / (scale - raw) in Q16 format */
+			u = (((uint32_t) scale) << 16) /
+				((uint32_t) (scale - raw));
+
+			/* log2(u) / n in Q16 format (log2(65536) == 16 << 16) */
+			u = (TLLog2Q16(u) - (((int32_t) 16) << 16) +
+				(d->tlStructSampleMethodState.CVD.nCharges >> 1)) /
+				d->tlStructSampleMethodState.CVD.nCharges;
+
+			/* 1 / ratio in Q16 format */
+			u = TLExp2M1Q16(u);
+			if (u == 0) {
+				u = 1;
+			}
+
+			/* ceil(ratio) */
+			d->tlStructSampleMethodState.CVD.nChargesNext =
+				(65536UL + u - 1) / u;
+
+			/*
+			 * value = referenceValue * scaleFactor * ratio;
+			 * u < 255 << 16 since n > 1, so TLDivQ16() applies.
+			 * Capacitances are not negative, so neither is
+			 * referenceValue * scaleFactor.
+			 */
+			v = TLDivQ16((uint32_t) (TL_CONFIG(d, referenceValue) *
+				TL_CONFIG(d, scaleFactor)), u);
+			tmp = (v > 0x7FFFFFFF) ? 0x7FFFFFFF : (int32_t) v;
+		} else {
+			tmp = ((TL_CONFIG(d, referenceValue) *
+				TL_CONFIG(d, scaleFactor) * (scale - d->raw)) +
+				(scale >> 1)) / scale;
+		}
+		d->value = (int32_t) tmp;
+
+		if (d->tlStructSampleMethodState.CVD.nChargesNext <
+				TL_N_CHARGES_MIN_DEFAULT) {
+			d->tlStructSampleMethodState.CVD.nChargesNext =
+				TL_N_CHARGES_MIN_DEFAULT;
+		}
+		if (d->tlStructSampleMethodState.CVD.nChargesNext >
+				TL_N_CHARGES_MAX_DEFAULT) {
+			d->tlStructSampleMethodState.CVD.nChargesNext =
+				TL_N_CHARGES_MAX_DEFAULT;
+		}
+		/* Capacitance can be negative due to noise! */
+	}
+
+	static int postSample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch, enum TLStruct::FilterType filterType)
+	{
+		struct TLStructSampleMethodCVDState * c;
+
+		#if defined(TL_METHOD_CVD_ADC_SESSION)
+		/*
+		 * All conversions of this scan are done; restore ADC
+		 * configuration
+		 */
+		TLAdcSessionEnd();
+		#endif
+
+		correctSample(data, nSensors, ch, rawScale(filterType,
+			data[ch].nMeasurementsPerSensor));
+
+		c = &(data[ch].tlStructSampleMethodState.CVD);
+		c->nCharges = c->nChargesNext;
+
+		return 0;
+	}
+
+	template <enum TLStruct::FilterType FILTER_TYPE>
+	static int postSample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch)
+	{
+		return postSample(data, nSensors, ch, FILTER_TYPE);
+	}
+};
+
+#endif
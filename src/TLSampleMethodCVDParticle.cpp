@@ -42,17 +42,21 @@
 
 static const unsigned char pin_to_adc_channel[8] = {15, 13, 12, 5, 6, 7, 4, 0};
 
+/*
+ * ADC session. Reconfiguring the ADC takes much longer than a conversion, so
+ * ADC1 is configured for single conversions once per scan (in
+ * TLSampleMethodCVDPreSample()) and the dual ADC configuration of the Particle
+ * firmware is restored once after the scan (in TLSampleMethodCVDPostSample()).
+ * Bit n of adcSessionChannels is set if channel n was read during the session.
+ */
+static bool adcSessionActive = false;
+static uint32_t adcSessionChannels = 0;
+
 void TLSetAdcReferencePin(int pin)
 {
-	long unsigned int reg;
-	long unsigned int *p;
-
-	p = (long unsigned int *) ADC1_BASE + offsetof(ADC_TypeDef, CR1);
-	reg = *p;
-	reg &= ~(0x1F);
-	//reg |= pin_to_adc_channel[pin - A0];
-	reg |= PIN_MAP[pin].adc_channel;
-	*p = reg;
+	/* Select channel of regular sequence (conversion 1) */
+	ADC1->SQR3 = (ADC1->SQR3 & ~((uint32_t) 0x1F)) |
+		PIN_MAP[pin].adc_channel;
 }
 
 int ADC_Init(void)
@@ -126,6 +130,51 @@ int ADC_ReInit(void)
 	return 0;
 }
 
+static bool TLAdcSessionIsValid(void)
+{
+	/*
+	 * Other code (e.g. analogRead() of the Particle firmware) may have
+	 * reconfigured the ADCs for dual mode during the session.
+	 */
+	return ((ADC->CCR & ADC_CCR_MULTI) == ADC_Mode_Independent) &&
+		(ADC1->CR2 & ADC_CR2_ADON);
+}
+
+void TLAdcSessionBegin(void)
+{
+	if (adcSessionActive && TLAdcSessionIsValid()) {
+		return;
+	}
+
+	ADC_Init();
+
+	adcSessionActive = true;
+}
+
+void TLAdcSessionEnd(void)
+{
+	uint8_t adc_ch;
+	uint8_t ADC_Sample_Time_Default = ADC_SampleTime_480Cycles;
+
+	if (!adcSessionActive) {
+		return;
+	}
+
+	ADC_ReInit();
+
+	for (adc_ch = 0; adc_ch < 32; adc_ch++) {
+		if (adcSessionChannels & (((uint32_t) 1) << adc_ch)) {
+			ADC_RegularChannelConfig(ADC1, adc_ch, 1,
+				ADC_Sample_Time_Default);
+			ADC_RegularChannelConfig(ADC2, adc_ch, 1,
+				ADC_Sample_Time_Default);
+		}
+	}
+
+	adcSessionActive = false;
+	adcSessionChannels = 0;
+}
+
 int TLAnalogRead(int pin)
 {
 	/*
@@ -134,26 +183,31 @@ int TLAnalogRead(int pin)
 	 */
 	uint8_t adc_ch;
 	uint8_t ADC_Sample_Time = ADC_SampleTime_3Cycles;
-	uint8_t ADC_Sample_Time_Default = ADC_SampleTime_480Cycles;
+	bool session;
 	int value;
 
 	adc_ch = PIN_MAP[pin].adc_channel;
 
-	ADC_Init();
+	/* Without session configure ADC for this single conversion */
+	session = adcSessionActive;
+	if (!session) {
+		TLAdcSessionBegin();
+	} else if (!TLAdcSessionIsValid()) {
+		ADC_Init();
+	}
+	adcSessionChannels |= ((uint32_t) 1) << adc_ch;
 
 	HAL_Pin_Mode(pin, AN_INPUT);
 	ADC_RegularChannelConfig(ADC1, adc_ch, 1, ADC_Sample_Time);
-	// ADC_RegularChannelConfig(ADC2, adc_ch, 1, ADC_Sample_Time);
 
 	ADC_SoftwareStartConv(ADC1);
 	while(ADC_GetFlagStatus(ADC1, ADC_FLAG_EOC) == RESET);
 
 	value = ADC_GetConversionValue(ADC1);
 
-	ADC_ReInit();
-
-	ADC_RegularChannelConfig(ADC1, adc_ch, 1, ADC_Sample_Time_Default);
-	ADC_RegularChannelConfig(ADC2, adc_ch, 1, ADC_Sample_Time_Default);
+	if (!session) {
+		TLAdcSessionEnd();
+	}
 
 	return value;
 }
@@ -50,9 +50,12 @@
 #define TL_ADC_MAX                                              ((1 << TL_ADC_RESOLUTION_BIT) - 1)
 
 #define TL_METHOD_CVD_SUPPORTED
+#define TL_METHOD_CVD_ADC_SESSION
 
 extern void TLSetAdcReferencePin(int pin);
 extern int TLAnalogRead(int pin);
+extern void TLAdcSessionBegin(void);
+extern void TLAdcSessionEnd(void);
 
 #endif
 
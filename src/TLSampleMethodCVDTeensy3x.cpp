@@ -30,6 +30,7 @@
 
 #include <stdint.h>
 #include "TouchLib.h"
+#include "TLSampleMethodCVD.h"
 #include "TLSampleMethodCVDTeensy3x.h"
 
 #include "BoardID.h"
@@ -92,24 +93,51 @@ static const uint8_t pin2sc1a[] = {
 #endif
 /* End of copied code */
 
-void TLSetAdcReferencePin(int pin)
+/*
+ * Returns ADC module (0 or 1) that converts pin or -1 if pin is not an analog
+ * pin.
+ */
+int8_t TLAdcModule(int pin)
 {
-	volatile uint32_t * ADCx_CFG2 = &ADC0_CFG2;
-	volatile uint32_t * ADCx_SC1A = &ADC0_SC1A;
 	uint8_t channel;
 
-	if (pin >= sizeof(pin2sc1a))
-		return;
+	if ((pin < 0) || (pin >= (int) sizeof(pin2sc1a)))
+		return -1;
 
 	channel = pin2sc1a[pin];
 
 	if (channel == 255)
+		return -1;
+
+	#if IS_TEENSY32_WITH_ADC1
+	if ((channel) & 0x80) {
+		return 1;
+	}
+	#endif
+
+	return 0;
+}
+
+/*
+ * Connects the ADC module of pin to pin. Writing SC1A starts a conversion;
+ * flags are or-ed into SC1A (e.g. ADC_SC1_AIEN to get an interrupt when the
+ * conversion has finished).
+ */
+static void TLAdcSelect(int pin, uint32_t flags)
+{
+	volatile uint32_t * ADCx_CFG2 = &ADC0_CFG2;
+	volatile uint32_t * ADCx_SC1A = &ADC0_SC1A;
+	uint8_t channel;
+
+	if (TLAdcModule(pin) < 0)
 		return;
 
+	channel = pin2sc1a[pin];
+
 	#if IS_TEENSY32_WITH_ADC1
 	if ((channel) & 0x80) {
-		*ADCx_CFG2 = ADC1_CFG2;
-		*ADCx_SC1A = ADC1_SC1A;
+		ADCx_CFG2 = &ADC1_CFG2;
+		ADCx_SC1A = &ADC1_SC1A;
 	}
 	#endif
 
@@ -119,10 +147,72 @@ void TLSetAdcReferencePin(int pin)
 	} else {
 		*ADCx_CFG2 |= ADC_CFG2_MUXSEL;
 	}
+	#else
+	if ((channel) & 0x40) {
+		*ADCx_CFG2 &= ~ADC_CFG2_MUXSEL;
+	} else {
+		*ADCx_CFG2 |= ADC_CFG2_MUXSEL;
+	}
+	#endif
+	*ADCx_SC1A = ((channel) & 0x1F) | flags;
+}
+
+void TLSetAdcReferencePin(int pin)
+{
+	TLAdcSelect(pin, 0);
+}
+
+#if defined(TL_METHOD_CVD_BACKGROUND_SUPPORTED)
+/*
+ * Background conversions. The sample method needs to toggle pins between the
+ * conversions of a scan, which cannot be done by DMA, so conversions are
+ * chained by the conversion complete interrupts instead. ADC0 and ADC1 have
+ * their own interrupt, so two conversions can be in flight.
+ */
+void TLAdcStartConversion(int pin)
+{
+	#if IS_TEENSY32_WITH_ADC1
+	if (TLAdcModule(pin) == 1) {
+		NVIC_ENABLE_IRQ(IRQ_ADC1);
+	} else {
+		NVIC_ENABLE_IRQ(IRQ_ADC0);
+	}
+	#else
+	NVIC_ENABLE_IRQ(IRQ_ADC0);
+	#endif
+	TLAdcSelect(pin, ADC_SC1_AIEN);
+}
+
+void TLAdcStopConversions(void)
+{
+	/* Disable interrupts and abort running conversions (channel 31) */
+	NVIC_DISABLE_IRQ(IRQ_ADC0);
+	ADC0_SC1A = 0x1F;
+	#if IS_TEENSY32_WITH_ADC1
+	NVIC_DISABLE_IRQ(IRQ_ADC1);
+	ADC1_SC1A = 0x1F;
 	#endif
-	*ADCx_SC1A = (channel) & 0x1F;
 }
 
+void TLAdcPoll(void)
+{
+	/* Conversions are chained by interrupts; nothing to do here */
+}
+
+void adc0_isr(void)
+{
+	/* Reading result clears conversion complete flag */
+	TLSampleMethodCVDConversionComplete(0, ADC0_RA);
+}
+
+#if IS_TEENSY32_WITH_ADC1
+void adc1_isr(void)
+{
+	TLSampleMethodCVDConversionComplete(1, ADC1_RA);
+}
+#endif
+#endif
+
 int TLAnalogRead(int pin)
 {
 	// Teensy accepts both Axx and xx notation; use Axx here
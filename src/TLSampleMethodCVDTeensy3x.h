@@ -52,8 +52,27 @@
 
 #define TL_METHOD_CVD_SUPPORTED
 
+/*
+ * Background scanning chains conversions from adc0_isr() and adc1_isr(), which
+ * TouchLib then defines, replacing the weak handlers of the core (and those of
+ * e.g. the ADC library). This is only done if TL_ENABLE_ADC_ISR is defined for
+ * the library build (e.g. in the compiler flags), like on ATmega.
+ */
+#if defined(TL_ENABLE_ADC_ISR)
+#define TL_METHOD_CVD_BACKGROUND_SUPPORTED
+#endif
+
+#if IS_TEENSY32_WITH_ADC1
+/* ADC0 and ADC1 can convert simultaneously */
+#define TL_ADC_N_MODULES				2
+#endif
+
 extern void TLSetAdcReferencePin(int pin);
 extern int TLAnalogRead(int pin);
+extern void TLAdcStartConversion(int pin);
+extern void TLAdcStopConversions(void);
+extern void TLAdcPoll(void);
+extern int8_t TLAdcModule(int pin);
 
 #endif
 #endif
@@ -28,7 +28,7 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifndef TLSampleMethodCVDUnsupported
+#ifndef TLSampleMethodCVDUnsupported_h
 #define TLSampleMethodCVDUnsupported_h
 
 #include <stdint.h>
@@ -47,15 +47,8 @@
 
 #define TL_ADC_MAX                                              ((1 << TL_ADC_RESOLUTION_BIT) - 1)
 
-#warning "CVD method is not supported on this processor"
-
-void TLSetAdcReferencePin(int pin)
-{
-}
-
-int TLAnalogRead(int pin)
-{
-	return 0;
-}
+/* Stubs; defined in TLSampleMethodCVD.cpp */
+extern void TLSetAdcReferencePin(int pin);
+extern int TLAnalogRead(int pin);
 
 #endif
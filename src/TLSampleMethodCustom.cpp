@@ -68,32 +68,34 @@ int32_t TLSampleMethodCustomMapDelta(struct TLStruct * data, uint8_t nSensors,
 
 int TLSampleMethodCustom(struct TLStruct * data, uint8_t nSensors, uint8_t ch)
 {
-	struct TLStruct * d;
+	struct TLStructConfig * c;
 
-	d = &(data[ch]);
+	/* A const configuration is used as is */
+	c = TLConfigWritable(&(data[ch]));
+	if (c == NULL) {
+		return 0;
+	}
 
-	d->sampleMethodPreSample = TLSampleMethodCustomPreSample;
-	d->sampleMethodSample = TLSampleMethodCustomSample;
-	d->sampleMethodPostSample = TLSampleMethodCustomPostSample;
-	d->sampleMethodMapDelta = TLSampleMethodCustomMapDelta;
+	c->sampleMethodPreSample = TLSampleMethodCustomPreSample;
+	c->sampleMethodSample = TLSampleMethodCustomSample;
+	c->sampleMethodPostSample = TLSampleMethodCustomPostSample;
+	c->sampleMethodMapDelta = TLSampleMethodCustomMapDelta;
 
-	d->tlStructSampleMethod.custom.pin = A0 + ch;
+	c->tlStructSampleMethod.custom.pin = A0 + ch;
 
-	d->releasedToApproachedThreshold = 
+	c->releasedToApproachedThreshold = 
 		TL_RELEASED_TO_APPROACHED_THRESHOLD_DEFAULT;
-	d->approachedToReleasedThreshold =
+	c->approachedToReleasedThreshold =
 		TL_APPROACHED_TO_RELEASED_THRESHOLD_DEFAULT;
-	d->approachedToPressedThreshold =
+	c->approachedToPressedThreshold =
 		TL_APPROACHED_TO_PRESSED_THRESHOLD_DEFAULT;     
-	d->pressedToApproachedThreshold =
+	c->pressedToApproachedThreshold =
 		TL_PRESSED_TO_APPROACHED_THRESHOLD_DEFAULT; 
 
-	d->direction = TLStruct::directionPositive;
-	d->sampleType = TLStruct::sampleTypeNormal;
-	d->waterRejectPin = -1;
-	d->waterRejectMode = TLStruct::waterRejectModeFloat;
-
-	d->pin = &(d->tlStructSampleMethod.custom.pin);
+	c->direction = TLStruct::directionPositive;
+	c->sampleType = TLStruct::sampleTypeNormal;
+	c->waterRejectPin = -1;
+	c->waterRejectMode = TLStruct::waterRejectModeFloat;
 
 	return 0;
 }
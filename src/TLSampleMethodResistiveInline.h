@@ -0,0 +1,275 @@
+/*
+ * TLSampleMethodResistiveInline.h - Inline parts of the resistive method for
+ * TouchLibrary for Arduino
+ *
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016 - 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TLSampleMethodResistiveInline_h
+#define TLSampleMethodResistiveInline_h
+
+/*
+ * Measurement and sample correction of the resistive method. These are inline
+ * so that TLSensorsStatic can call them directly from its scan loop; the
+ * functions in TLSampleMethodResistive.cpp use the same code. Included by
+ * TouchLib.h after struct TLStructConfig.
+ */
+
+#include <stdint.h>
+#include "BoardID.h"
+
+#define TL_RESISTIVE_USE_CORRECT_TRANSFER_FUNCTION	0
+
+#if IS_PARTICLE
+#define TL_RESISTIVE_ADC_RESOLUTION_BIT			12
+#elif IS_ESP32
+#define TL_RESISTIVE_ADC_RESOLUTION_BIT			12
+#elif IS_ATMEGA
+#define TL_RESISTIVE_ADC_RESOLUTION_BIT			10
+#else
+#define TL_RESISTIVE_ADC_RESOLUTION_BIT			10
+#endif
+
+#define TL_RESISTIVE_ADC_MAX				\
+	((1 << TL_RESISTIVE_ADC_RESOLUTION_BIT) - 1)
+
+#define TL_RESISTIVE_USE_INTERNAL_PULLUP_DEFAULT	true
+
+/* ATmega2560 has internal pull-ups of 20 - 50 kOhm. Assume it is 35 kOhm */
+#define TL_RESISTIVE_REFERENCE_VALUE_DEFAULT		((int32_t) 35000) /* 32 kOhm */
+#define TL_RESISTIVE_SCALE_FACTOR_DEFAULT		((int32_t) 1)
+#define TL_RESISTIVE_VALUE_MAX_DEFAULT			((int32_t) 8000000) /* 8 MOhm */
+#define TL_RESISTIVE_OFFSET_VALUE_DEFAULT		((int32_t) 0) /* Ohm */
+
+#if (TL_RESISTIVE_USE_CORRECT_TRANSFER_FUNCTION == 1)
+
+#define TL_RESISTIVE_RELEASED_TO_APPROACHED_THRESHOLD_DEFAULT	\
+	(TL_RESISTIVE_VALUE_MAX_DEFAULT - 4500)
+#define TL_RESISTIVE_APPROACHED_TO_RELEASED_THRESHOLD_DEFAULT	\
+	(TL_RESISTIVE_VALUE_MAX_DEFAULT - 5500)
+#define TL_RESISTIVE_APPROACHED_TO_PRESSED_THRESHOLD_DEFAULT	\
+	(TL_RESISTIVE_VALUE_MAX_DEFAULT - 800)
+#define TL_RESISTIVE_PRESSED_TO_APPROACHED_THRESHOLD_DEFAULT	\
+	(TL_RESISTIVE_VALUE_MAX_DEFAULT - 1000)
+
+#else
+
+#define TL_RESISTIVE_RELEASED_TO_APPROACHED_THRESHOLD_DEFAULT	0.5
+#define TL_RESISTIVE_APPROACHED_TO_RELEASED_THRESHOLD_DEFAULT	0.25
+#define TL_RESISTIVE_APPROACHED_TO_PRESSED_THRESHOLD_DEFAULT	5
+#define TL_RESISTIVE_PRESSED_TO_APPROACHED_THRESHOLD_DEFAULT	4
+
+#endif
+
+/*
+ * Configuration of a resistive sensor on pin with its other side on gndPin
+ * (-1 if not used) with the defaults of the library, for constant
+ * initializers of configurations (see TLSensors::setConfig()). This is the
+ * configuration that TLSampleMethodResistive() sets, apart from the pins.
+ */
+constexpr struct TLStructConfig TLSampleMethodResistiveConfig(int pin,
+		int gndPin, int32_t releasedToApproachedThreshold =
+		TL_RESISTIVE_RELEASED_TO_APPROACHED_THRESHOLD_DEFAULT,
+		int32_t approachedToReleasedThreshold =
+		TL_RESISTIVE_APPROACHED_TO_RELEASED_THRESHOLD_DEFAULT,
+		int32_t approachedToPressedThreshold =
+		TL_RESISTIVE_APPROACHED_TO_PRESSED_THRESHOLD_DEFAULT,
+		int32_t pressedToApproachedThreshold =
+		TL_RESISTIVE_PRESSED_TO_APPROACHED_THRESHOLD_DEFAULT)
+{
+	return TLStructConfigMake(TLStructSampleMethodResistive {
+			pin,
+			gndPin,
+			TL_RESISTIVE_USE_INTERNAL_PULLUP_DEFAULT,
+			TL_RESISTIVE_VALUE_MAX_DEFAULT
+		}, TLSampleMethodResistive, TLSampleMethodResistivePreSample,
+		TLSampleMethodResistiveSample,
+		TLSampleMethodResistivePostSample,
+		TLSampleMethodResistiveMapDelta,
+		TL_RESISTIVE_REFERENCE_VALUE_DEFAULT,
+		TL_RESISTIVE_SCALE_FACTOR_DEFAULT,
+		releasedToApproachedThreshold, approachedToReleasedThreshold,
+		approachedToPressedThreshold, pressedToApproachedThreshold,
+		TLStruct::directionNegative, TLStruct::sampleTypeNormal);
+}
+
+/*
+ * Sample method policy for TLSensorsStatic. TLSampleMethodResistiveSample()
+ * and TLSampleMethodResistivePostSample() call these functions as well.
+ * postSample() takes the filter type as a template argument, so that the scale
+ * of raw is a constant.
+ */
+struct TLSampleMethodResistivePolicy {
+	/* Sample method to pass to TLSensors::initialize() */
+	static int (*sampleMethod(void))(struct TLStruct * data,
+			uint8_t nSensors, uint8_t ch)
+	{
+		return TLSampleMethodResistive;
+	}
+
+	static int preSample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch)
+	{
+		return 0;
+	}
+
+	static int32_t sample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch, bool inv)
+	{
+		struct TLStruct * dCh;
+		int ch_pin, gnd_pin;
+		int32_t sample;
+		bool useInternalPullup;
+
+		if (inv) {
+			/* Pseudo differential measurements are not supported */
+			return 0;
+		}
+
+		dCh = &(data[ch]);
+		ch_pin = TL_CONFIG(dCh, tlStructSampleMethod.resistive.pin);
+		gnd_pin = TL_CONFIG(dCh, tlStructSampleMethod.resistive.gndPin);
+		useInternalPullup = TL_CONFIG(dCh,
+			tlStructSampleMethod.resistive.useInternalPullup);
+
+		if (ch_pin < 0) {
+			return 0; /* An error occurred */
+		}
+
+		if (useInternalPullup) {
+			/* Enable internal pull-up on analog input */
+			pinMode(ch_pin, INPUT_PULLUP);
+		} else {
+			/* Disable internal pull-up on analog input */
+			pinMode(ch_pin, INPUT);
+		}
+
+		if (gnd_pin >= 0) {
+			/* Configure gnd_pin as digital output, low (gnd) */
+			pinMode(gnd_pin, OUTPUT);
+			digitalWrite(gnd_pin, LOW);
+		}
+
+		/* Read */
+		sample = analogRead(ch_pin);
+
+		/* Disable internal pull-up on analog input */
+		pinMode(ch_pin, INPUT);
+
+		if (gnd_pin >= 0) {
+			/* Leave gnd_pin floating */
+			pinMode(gnd_pin, INPUT);
+			digitalWrite(gnd_pin, LOW);
+		}
+
+		return sample;
+	}
+
+	/* Full scale of raw for filterType */
+	static int32_t rawScale(enum TLStruct::FilterType filterType,
+			uint8_t nMeasurementsPerSensor)
+	{
+		switch (filterType) {
+		case TLStruct::filterTypeAverage:
+		case TLStruct::filterTypeIIR:
+		case TLStruct::filterTypeMedian3:
+		case TLStruct::filterTypeTrimmedMean:
+			/*
+			 * Raw is scaled to the sum of nMeasurementsPerSensor
+			 * samples
+			 */
+			return (((int32_t) nMeasurementsPerSensor) << 1) *
+				(TL_RESISTIVE_ADC_MAX + 1);
+		case TLStruct::filterTypeSlewrateLimiter:
+			return ((TL_RESISTIVE_ADC_MAX + 1) << 2);
+		case TLStruct::filterTypeMedian:
+			return ((TL_RESISTIVE_ADC_MAX + 1) << 2);
+		default:
+			/* Error! */
+			return ((TL_RESISTIVE_ADC_MAX + 1) << 2);
+		}
+	}
+
+	static void correctSample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch, int32_t scale)
+	{
+		TLStruct * d;
+		int32_t tmp;
+
+		d = &(data[ch]);
+
+		#if (TL_RESISTIVE_USE_CORRECT_TRANSFER_FUNCTION == 1)
+
+		int32_t denum, valueMax;
+
+		/*
+		 * Actual transfer function is
+		 * (d->raw / scale) / (1 - (d->raw / scale)), but this is very
+		 * sensitive to noise when sensor is not pressed (since tmp
+		 * will then be very close to 1). Instead, clip the value to a
+		 * predefined maximum.
+		 */
+		if (d->raw > scale) {
+			d->raw = scale;
+		}
+		denum = scale - d->raw;
+		tmp = (TL_CONFIG(d, scaleFactor) * TL_CONFIG(d,
+			referenceValue) * d->raw + (denum >> 1)) / denum;
+
+		valueMax = TL_CONFIG(d, tlStructSampleMethod.resistive.valueMax);
+		if (tmp > valueMax) {
+			tmp = valueMax;
+		}
+
+		#else
+
+		tmp = TL_CONFIG(d, scaleFactor) * TL_CONFIG(d,
+			referenceValue) * d->raw / scale;
+
+		#endif
+
+		d->value = tmp;
+		/* Resistance can be negative due to noise! */
+	}
+
+	static int postSample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch, enum TLStruct::FilterType filterType)
+	{
+		correctSample(data, nSensors, ch, rawScale(filterType,
+			data[ch].nMeasurementsPerSensor));
+
+		return 0;
+	}
+
+	template <enum TLStruct::FilterType FILTER_TYPE>
+	static int postSample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch)
+	{
+		return postSample(data, nSensors, ch, FILTER_TYPE);
+	}
+};
+
+#endif
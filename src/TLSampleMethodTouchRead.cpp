@@ -30,6 +30,7 @@
 
 #include "TouchLib.h"
 #include "TLSampleMethodTouchRead.h"
+#include "TLFixedPoint.h"
 
 #if (IS_ESP32)
 /*
@@ -63,8 +64,8 @@
 #define TL_PRESSED_TO_APPROACHED_THRESHOLD_DEFAULT	6.0
 #define TL_TOUCHREAD_MAX				((1 << 16) - 1)
 
-#define TL_BAR_LOWER_PCT				40
-#define TL_BAR_UPPER_PCT				80
+#define TL_TOUCHREAD_BAR_LOWER_PCT			40
+#define TL_TOUCHREAD_BAR_UPPER_PCT			80
 
 #if (IS_ESP32)
 static uint16_t __touchSleepCycles = 0x1000;
@@ -130,6 +131,102 @@ void __touchInit()
 	esp_intr_alloc(ETS_RTC_CORE_INTR_SOURCE, (int)ESP_INTR_FLAG_IRAM, __touchISR, NULL, &touch_intr_handle);
 }
 
+static void __touchPadConfig(int8_t pad)
+{
+	uint32_t rtc_tio_reg = RTC_IO_TOUCH_PAD0_REG + pad * 4;
+	WRITE_PERI_REG(rtc_tio_reg, (READ_PERI_REG(rtc_tio_reg)
+					  & ~(RTC_IO_TOUCH_PAD0_DAC_M))
+					  | (7 << RTC_IO_TOUCH_PAD0_DAC_S)//Touch Set Slope
+					  | RTC_IO_TOUCH_PAD0_TIE_OPT_M   //Enable Tie,Init Level
+					  | RTC_IO_TOUCH_PAD0_START_M	 //Enable Touch Pad IO
+					  | RTC_IO_TOUCH_PAD0_XPD_M);	 //Enable Touch Pad Power on
+}
+
+#if defined(TL_ENABLE_ESP32_TOUCH_TIMER_SCAN)
+/*
+ * Number of cycles of the 150 kHz RTC slow clock between two scans of the
+ * touch FSM; 0x100 is about 1.7 ms.
+ */
+#define TL_ESP32_TOUCH_SLEEP_CYCLES			0x100
+
+/* Maximum time to wait for the first measurement of a newly enabled pad */
+#define TL_ESP32_TOUCH_FIRST_MEASUREMENT_TIMEOUT_US	50000
+
+static bool __touchTimerInitialized = false;
+static uint16_t __touchTimerPads = 0;
+/* Pads that have not been read since they were enabled */
+static uint16_t __touchTimerFirstReadPads = 0;
+/* Last non-zero measurement of each pad */
+static uint16_t __touchTimerLastValue[10] = {0,};
+
+static void esp32TouchTimerEnablePad(uint8_t pin, int8_t pad)
+{
+	if (!__touchTimerInitialized) {
+		__touchSleepCycles = TL_ESP32_TOUCH_SLEEP_CYCLES;
+		__touchInit();
+
+		/* Let the sleep timer start the measurements */
+		CLEAR_PERI_REG_MASK(SENS_SAR_TOUCH_CTRL2_REG,
+			SENS_TOUCH_START_EN_M | SENS_TOUCH_START_FORCE_M);
+		SET_PERI_REG_BITS(SENS_SAR_TOUCH_CTRL1_REG, SENS_TOUCH_XPD_WAIT,
+			10, SENS_TOUCH_XPD_WAIT_S);
+
+		__touchTimerInitialized = true;
+	}
+
+	pinMode(pin, ANALOG);
+	__touchPadConfig(pad);
+
+	/* Add pad to the pads that are scanned (without interrupt) */
+	SET_PERI_REG_MASK(SENS_SAR_TOUCH_ENABLE_REG,
+		(1 << (pad + SENS_TOUCH_PAD_WORKEN_S)));
+
+	__touchTimerPads |= 1 << pad;
+	__touchTimerFirstReadPads |= 1 << pad;
+}
+
+uint16_t esp32TouchTimerRead(uint8_t pin)
+{
+	int8_t pad = digitalPinToTouchChannel(pin);
+	unsigned long t;
+	uint16_t touch_value;
+
+	if (pad < 0) {
+		return 0;
+	}
+
+	if (!(__touchTimerPads & (1 << pad))) {
+		esp32TouchTimerEnablePad(pin, pad);
+	}
+
+	t = micros();
+	do {
+		touch_value = READ_PERI_REG(SENS_SAR_TOUCH_OUT1_REG + (pad / 2) * 4) >> ((pad & 1) ? SENS_TOUCH_MEAS_OUT1_S : SENS_TOUCH_MEAS_OUT0_S);
+
+		/*
+		 * Output is 0 until the pad has been measured once; only wait
+		 * for that on the first read after enabling the pad
+		 */
+	} while ((touch_value == 0) &&
+		(__touchTimerFirstReadPads & (1 << pad)) &&
+		(micros() - t < TL_ESP32_TOUCH_FIRST_MEASUREMENT_TIMEOUT_US));
+
+	__touchTimerFirstReadPads &= ~(1 << pad);
+
+	if (touch_value == 0) {
+		/*
+		 * Workaround for ESP32 which sometimes returns 0: use the
+		 * previous measurement instead
+		 */
+		touch_value = __touchTimerLastValue[pad];
+	} else {
+		__touchTimerLastValue[pad] = touch_value;
+	}
+
+	return touch_value;
+}
+#endif
+
 uint16_t esp32TouchRead(uint8_t pin)
 {
 	int8_t pad = digitalPinToTouchChannel(pin);
@@ -150,13 +247,7 @@ uint16_t esp32TouchRead(uint8_t pin)
 
 	SET_PERI_REG_MASK(SENS_SAR_TOUCH_ENABLE_REG, (1 << (pad + SENS_TOUCH_PAD_WORKEN_S)));
 
-	uint32_t rtc_tio_reg = RTC_IO_TOUCH_PAD0_REG + pad * 4;
-	WRITE_PERI_REG(rtc_tio_reg, (READ_PERI_REG(rtc_tio_reg)
-					  & ~(RTC_IO_TOUCH_PAD0_DAC_M))
-					  | (7 << RTC_IO_TOUCH_PAD0_DAC_S)//Touch Set Slope
-					  | RTC_IO_TOUCH_PAD0_TIE_OPT_M   //Enable Tie,Init Level
-					  | RTC_IO_TOUCH_PAD0_START_M	 //Enable Touch Pad IO
-					  | RTC_IO_TOUCH_PAD0_XPD_M);	 //Enable Touch Pad Power on
+	__touchPadConfig(pad);
 
 	//force oneTime test start
 	SET_PERI_REG_MASK(SENS_SAR_TOUCH_CTRL2_REG, SENS_TOUCH_START_EN_M|SENS_TOUCH_START_FORCE_M);
@@ -188,21 +279,26 @@ int32_t TLSampleMethodTouchReadSample(struct TLStruct * data, uint8_t nSensors,
 {
 	int32_t sample = 0;
 	
-	/* touchRead() is only available on ESP32 and Teensy 3.x and not Teensy 3.5 */
+	/*
+	 * touchRead() is only available on ESP32 and Teensy 3.x and not Teensy
+	 * 3.5. The host backend simulates it.
+	 */
 
-	#if ((IS_TEENSY_WITH_TOUCHREAD) || (IS_ESP32))
+	#if ((IS_TEENSY_WITH_TOUCHREAD) || (IS_ESP32) || (IS_HOST))
 	struct TLStruct * dCh;
 	int ch_pin;
 
 	dCh = &(data[ch]);
-	ch_pin = dCh->tlStructSampleMethod.touchRead.pin;
+	ch_pin = TL_CONFIG(dCh, tlStructSampleMethod.touchRead.pin);
 	if (inv) {
 		/* Pseudo differential measurements are not supported */
 		sample = 0;
 	} else {
 
 		if (ch_pin >= 0) {
-			#if (IS_ESP32)
+			#if ((IS_ESP32) && defined(TL_ENABLE_ESP32_TOUCH_TIMER_SCAN))
+			sample = esp32TouchTimerRead(ch_pin);
+			#elif (IS_ESP32)
 			/* discharge pin */
 			pinMode(ch_pin, OUTPUT);
 			digitalWrite(ch_pin, LOW);
@@ -212,7 +308,7 @@ int32_t TLSampleMethodTouchReadSample(struct TLStruct * data, uint8_t nSensors,
 			sample = touchRead(ch_pin);
 			#endif
 
-			#if (IS_ESP32)
+			#if ((IS_ESP32) && !defined(TL_ENABLE_ESP32_TOUCH_TIMER_SCAN))
 			if (sample == 0) {
 				/* 
 				 * Workaround for ESP32 which sometimes returns
@@ -244,49 +340,31 @@ int32_t TLSampleMethodTouchReadSample(struct TLStruct * data, uint8_t nSensors,
 int TLSampleMethodTouchReadPostSample(struct TLStruct * data, uint8_t nSensors,
 		uint8_t ch)
 {
-        TLStruct * d;
-        int32_t tmp, scale;
-
-        d = &(data[ch]);
-
-	switch (d->filterType) {
-	case TLStruct::filterTypeAverage:
-                scale = (((int32_t) d->nMeasurementsPerSensor) << 1);
-		break;
-	case TLStruct::filterTypeSlewrateLimiter:
-                scale = 2;
-		break;
-	case TLStruct::filterTypeMedian:
-                scale = 2;
-		break;
-	default:
-		/* Error! */
-		scale = 2;
-	}
-
-        tmp = (d->scaleFactor * d->referenceValue * d->raw + (scale >> 1)) / 
-		scale;
-        d->value = tmp;
-        /* Capacitance can be negative due to noise! */
-
-        return 0;
+	return TLSampleMethodTouchReadPolicy::postSample(data, nSensors, ch,
+		TL_CONFIG(&(data[ch]), filterType));
 }
 
-
 int32_t TLSampleMethodTouchReadMapDelta(struct TLStruct * data, uint8_t nSensors,
 		uint8_t ch, int length)
 {
 	int32_t n = -1;
 	struct TLStruct * d;
-	int32_t delta;
+	int32_t delta, calibratedMaxDelta;
 
 	d = &(data[ch]);
 
 	delta = d->delta;
 
-	n = map(100 * log(delta), TL_BAR_LOWER_PCT *
-			log(d->calibratedMaxDelta), TL_BAR_UPPER_PCT *
-			log(d->calibratedMaxDelta), 0.0f, (float) length);
+	calibratedMaxDelta = TL_CONFIG(d, calibratedMaxDelta);
+	if ((delta <= 0) || (calibratedMaxDelta <= 1)) {
+		return 0;
+	}
+
+	/* Logarithms are in Q8 format to prevent overflow in map() */
+	n = map(100 * (TLLog2Q16(delta) >> 8), TL_TOUCHREAD_BAR_LOWER_PCT *
+			(TLLog2Q16(calibratedMaxDelta) >> 8),
+			TL_TOUCHREAD_BAR_UPPER_PCT *
+			(TLLog2Q16(calibratedMaxDelta) >> 8), 0, length);
 
 	n = (n < 0) ? 0 : n;
 	n = (n > length) ? length : n;
@@ -298,50 +376,56 @@ int TLSampleMethodTouchRead(struct TLStruct * data, uint8_t nSensors,
 		uint8_t ch)
 {
 	struct TLStruct * d;
+	struct TLStructConfig * c;
 
 	d = &(data[ch]);
 
-	d->sampleMethodPreSample = TLSampleMethodTouchReadPreSample;
-	d->sampleMethodSample = TLSampleMethodTouchReadSample;
-	d->sampleMethodPostSample = TLSampleMethodTouchReadPostSample;
-	d->sampleMethodMapDelta = TLSampleMethodTouchReadMapDelta;
+	d->offsetValue = TL_OFFSET_VALUE_DEFAULT;
+
+	/* A const configuration is used as is */
+	c = TLConfigWritable(d);
+	if (c == NULL) {
+		return 0;
+	}
+
+	c->sampleMethodPreSample = TLSampleMethodTouchReadPreSample;
+	c->sampleMethodSample = TLSampleMethodTouchReadSample;
+	c->sampleMethodPostSample = TLSampleMethodTouchReadPostSample;
+	c->sampleMethodMapDelta = TLSampleMethodTouchReadMapDelta;
 
 	if (ch < 2) {
-		d->tlStructSampleMethod.touchRead.pin = (ch + 0);
+		c->tlStructSampleMethod.touchRead.pin = (ch + 0);
 	} else if (ch < 7) {
-		d->tlStructSampleMethod.touchRead.pin = (ch - 2 + 15);
+		c->tlStructSampleMethod.touchRead.pin = (ch - 2 + 15);
 	} else if (ch < 9) {
-		d->tlStructSampleMethod.touchRead.pin = (ch - 7 + 22);
+		c->tlStructSampleMethod.touchRead.pin = (ch - 7 + 22);
 	} else {
-		d->tlStructSampleMethod.touchRead.pin = (ch - 9 + 29);
+		c->tlStructSampleMethod.touchRead.pin = (ch - 9 + 29);
 	}
 
-	d->referenceValue = TL_REFERENCE_VALUE_DEFAULT;
-	d->offsetValue = TL_OFFSET_VALUE_DEFAULT;
-	d->scaleFactor = TL_SCALE_FACTOR_DEFAULT;
-	d->setOffsetValueManually = TL_SET_OFFSET_VALUE_MANUALLY_DEFAULT;
+	c->referenceValue = TL_REFERENCE_VALUE_DEFAULT;
+	c->scaleFactor = TL_SCALE_FACTOR_DEFAULT;
+	c->setOffsetValueManually = TL_SET_OFFSET_VALUE_MANUALLY_DEFAULT;
 
-	d->releasedToApproachedThreshold =
+	c->releasedToApproachedThreshold =
 		TL_RELEASED_TO_APPROACHED_THRESHOLD_DEFAULT;
-	d->approachedToReleasedThreshold =
+	c->approachedToReleasedThreshold =
 		TL_APPROACHED_TO_RELEASED_THRESHOLD_DEFAULT;
-	d->approachedToPressedThreshold =
+	c->approachedToPressedThreshold =
 		TL_APPROACHED_TO_PRESSED_THRESHOLD_DEFAULT;
-	d->pressedToApproachedThreshold =
+	c->pressedToApproachedThreshold =
 		TL_PRESSED_TO_APPROACHED_THRESHOLD_DEFAULT;
 
 	#if (IS_ESP32)
-	d->direction = TLStruct::directionNegative;
+	c->direction = TLStruct::directionNegative;
 	#else
-	d->direction = TLStruct::directionPositive;
+	c->direction = TLStruct::directionPositive;
 	#endif
 
-	d->sampleType = TLStruct::sampleTypeNormal;
-	d->filterType = TLStruct::filterTypeAverage;
-	d->waterRejectPin = -1;
-	d->waterRejectMode = TLStruct::waterRejectModeFloat;
-
-	d->pin = &(d->tlStructSampleMethod.touchRead.pin);
+	c->sampleType = TLStruct::sampleTypeNormal;
+	c->filterType = TLStruct::filterTypeAverage;
+	c->waterRejectPin = -1;
+	c->waterRejectMode = TLStruct::waterRejectModeFloat;
 
 	return 0;
 }
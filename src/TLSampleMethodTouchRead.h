@@ -33,6 +33,21 @@
 
 #include <TouchLib.h>
 
+/*
+ * If TL_ENABLE_ESP32_TOUCH_TIMER_SCAN is defined for the library build (e.g. in
+ * the compiler flags), the touch peripheral of the ESP32 scans all used pads
+ * continuously with its hardware timer; TLSampleMethodTouchReadSample() then
+ * returns the most recent measurement of the pad without waiting. By default a
+ * new measurement is started and waited for on every sample.
+ *
+ * Consecutive samples of a pad within one scan period of the hardware
+ * (TL_ESP32_TOUCH_SLEEP_CYCLES plus the measurement time of all used pads)
+ * return the same value. The nMeasurementsPerSensor measurements of a scan are
+ * therefore mostly repeated register values, so filterTypeAverage (and the
+ * other filters that combine the measurements of a scan) no longer averages
+ * independent samples; use filterTypeIIR across scans instead.
+ */
+
 struct TLStructSampleMethodTouchRead {
         int pin;
 };
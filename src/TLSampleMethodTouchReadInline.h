@@ -0,0 +1,121 @@
+/*
+ * TLSampleMethodTouchReadInline.h - Inline parts of the TouchRead method for
+ * TouchLibrary for Arduino
+ *
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016 - 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TLSampleMethodTouchReadInline_h
+#define TLSampleMethodTouchReadInline_h
+
+/*
+ * Sample correction of the TouchRead method. It is inline so that
+ * TLSensorsStatic can call it directly from its scan loop;
+ * TLSampleMethodTouchReadPostSample() uses the same code. The measurement
+ * itself stays in TLSampleMethodTouchRead.cpp, which keeps the state of the
+ * ESP32 touch peripheral. Included by TouchLib.h after struct TLStructConfig.
+ */
+
+#include <stdint.h>
+
+/*
+ * Sample method policy for TLSensorsStatic. postSample() takes the filter type
+ * as a template argument, so that the scale of raw is a constant.
+ */
+struct TLSampleMethodTouchReadPolicy {
+	/* Sample method to pass to TLSensors::initialize() */
+	static int (*sampleMethod(void))(struct TLStruct * data,
+			uint8_t nSensors, uint8_t ch)
+	{
+		return TLSampleMethodTouchRead;
+	}
+
+	static int preSample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch)
+	{
+		return TLSampleMethodTouchReadPreSample(data, nSensors, ch);
+	}
+
+	static int32_t sample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch, bool inv)
+	{
+		return TLSampleMethodTouchReadSample(data, nSensors, ch, inv);
+	}
+
+	/* Full scale of raw for filterType, in touchRead() counts */
+	static int32_t rawScale(enum TLStruct::FilterType filterType,
+			uint8_t nMeasurementsPerSensor)
+	{
+		switch (filterType) {
+		case TLStruct::filterTypeAverage:
+		case TLStruct::filterTypeIIR:
+		case TLStruct::filterTypeMedian3:
+		case TLStruct::filterTypeTrimmedMean:
+			/*
+			 * Raw is scaled to the sum of nMeasurementsPerSensor
+			 * samples
+			 */
+			return (((int32_t) nMeasurementsPerSensor) << 1);
+		case TLStruct::filterTypeSlewrateLimiter:
+			return 2;
+		case TLStruct::filterTypeMedian:
+			return 2;
+		default:
+			/* Error! */
+			return 2;
+		}
+	}
+
+	static void correctSample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch, int32_t scale)
+	{
+		TLStruct * d;
+
+		d = &(data[ch]);
+
+		d->value = (TL_CONFIG(d, scaleFactor) * TL_CONFIG(d,
+			referenceValue) * d->raw + (scale >> 1)) / scale;
+		/* Capacitance can be negative due to noise! */
+	}
+
+	static int postSample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch, enum TLStruct::FilterType filterType)
+	{
+		correctSample(data, nSensors, ch, rawScale(filterType,
+			data[ch].nMeasurementsPerSensor));
+
+		return 0;
+	}
+
+	template <enum TLStruct::FilterType FILTER_TYPE>
+	static int postSample(struct TLStruct * data, uint8_t nSensors,
+			uint8_t ch)
+	{
+		return postSample(data, nSensors, ch, FILTER_TYPE);
+	}
+};
+
+#endif
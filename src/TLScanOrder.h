@@ -0,0 +1,161 @@
+/*
+ * TLScanOrder.h - Compile time scan order for TouchLibrary for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TLScanOrder_h
+#define TLScanOrder_h
+
+#include <stdint.h>
+#include "BoardID.h"
+
+/*
+ * The default scan order is a pseudo random permutation of the positions
+ * 0 ... N_SENSORS * N_MEASUREMENTS_PER_SENSOR - 1, of which the value modulo
+ * N_SENSORS is the channel measured at that position. Each channel is thus
+ * measured exactly N_MEASUREMENTS_PER_SENSOR times per scan, at positions that
+ * are spread over the scan so that periodic interference does not line up with
+ * a single channel.
+ *
+ * The table is generated by the compiler and is const, so it is stored in
+ * flash (PROGMEM on AVR, where it must be read with TL_SCAN_ORDER_READ()).
+ * Only C++11 constexpr is used (single return statement functions), since that
+ * is what the Arduino AVR toolchain supports.
+ */
+#if IS_AVR
+#include <avr/pgmspace.h>
+#define TL_SCAN_ORDER_ATTR				PROGMEM
+#define TL_SCAN_ORDER_READ(t, k)			pgm_read_byte(&((t)[k]))
+#else
+#define TL_SCAN_ORDER_ATTR
+#define TL_SCAN_ORDER_READ(t, k)			((t)[k])
+#endif
+
+/* Smallest 2^k - 1 with 2^k >= length */
+constexpr uint16_t TLScanOrderMask(uint16_t length, uint16_t mask = 1)
+{
+	return (mask >= length - 1) ? mask :
+		TLScanOrderMask(length, (mask << 1) | 1);
+}
+
+/* Number of bits set in mask (mask is 2^k - 1) */
+constexpr uint8_t TLScanOrderBits(uint16_t mask)
+{
+	return (mask == 0) ? 0 : 1 + TLScanOrderBits(mask >> 1);
+}
+
+constexpr uint16_t TLScanOrderXorShift(uint16_t x, uint8_t shift)
+{
+	return x ^ (x >> shift);
+}
+
+/*
+ * One round of the permutation of 0 ... mask: add a constant, multiply by an
+ * odd constant and xor with the upper half; each step is invertible modulo
+ * mask + 1.
+ */
+constexpr uint16_t TLScanOrderRound(uint16_t x, uint16_t mask, uint8_t shift,
+		uint16_t c)
+{
+	return TLScanOrderXorShift((uint16_t) ((((uint32_t) x + c) * 0x9E5) &
+		mask), shift);
+}
+
+constexpr uint16_t TLScanOrderPermute(uint16_t x, uint16_t mask, uint8_t shift)
+{
+	return TLScanOrderRound(TLScanOrderRound(TLScanOrderRound(x, mask,
+		shift, 0x3C1), mask, shift, 0x1A7), mask, shift, 0x2D5);
+}
+
+/*
+ * Cycle walking: apply the permutation until the result is a valid position.
+ * This is a permutation of 0 ... length - 1.
+ */
+constexpr uint16_t TLScanOrderWalk(uint16_t x, uint16_t length, uint16_t mask,
+		uint8_t shift)
+{
+	return (x < length) ? x : TLScanOrderWalk(TLScanOrderPermute(x, mask,
+		shift), length, mask, shift);
+}
+
+constexpr uint8_t TLScanOrderChannel(uint16_t pos, uint8_t nSensors,
+		uint16_t length)
+{
+	return TLScanOrderWalk(TLScanOrderPermute(pos, TLScanOrderMask(length),
+		(TLScanOrderBits(TLScanOrderMask(length)) + 1) / 2), length,
+		TLScanOrderMask(length), (TLScanOrderBits(
+		TLScanOrderMask(length)) + 1) / 2) % nSensors;
+}
+
+/*
+ * List of indices 0 ... N - 1 as template arguments, built by halving so that
+ * the template recursion depth is log2(N) instead of N.
+ */
+template <uint16_t... I>
+struct TLIndexList {
+	typedef TLIndexList type;
+};
+
+template <class A, class B>
+struct TLIndexListConcat;
+
+template <uint16_t... I, uint16_t... J>
+struct TLIndexListConcat<TLIndexList<I...>, TLIndexList<J...> > :
+	TLIndexList<I..., (uint16_t) (sizeof...(I) + J)...> {
+};
+
+template <uint16_t N>
+struct TLMakeIndexList : TLIndexListConcat<
+	typename TLMakeIndexList<N / 2>::type,
+	typename TLMakeIndexList<N - N / 2>::type> {
+};
+
+template <>
+struct TLMakeIndexList<0> : TLIndexList<> {
+};
+
+template <>
+struct TLMakeIndexList<1> : TLIndexList<0> {
+};
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR,
+	class INDICES = typename TLMakeIndexList<((uint16_t) N_SENSORS) *
+	N_MEASUREMENTS_PER_SENSOR>::type>
+struct TLScanOrderTable;
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR, uint16_t... I>
+struct TLScanOrderTable<N_SENSORS, N_MEASUREMENTS_PER_SENSOR,
+		TLIndexList<I...> > {
+	static const uint8_t table[sizeof...(I)];
+};
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR, uint16_t... I>
+const uint8_t TLScanOrderTable<N_SENSORS, N_MEASUREMENTS_PER_SENSOR,
+		TLIndexList<I...> >::table[sizeof...(I)] TL_SCAN_ORDER_ATTR = {
+	TLScanOrderChannel(I, N_SENSORS, sizeof...(I))...
+};
+
+#endif
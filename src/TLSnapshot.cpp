@@ -0,0 +1,134 @@
+/*
+ * TLSnapshot.cpp - Warm start snapshots for TouchLibrary for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include "TouchLib.h"
+#include "TLSnapshot.h"
+#include "BoardID.h"
+
+#if (IS_AVR || IS_TEENSY3X || IS_TEENSYLC || IS_ESP32)
+#include <EEPROM.h>
+#define TL_STORAGE_EEPROM_SUPPORTED
+#elif IS_PARTICLE
+/* EEPROM is part of the Particle firmware API */
+#define TL_STORAGE_EEPROM_SUPPORTED
+#elif IS_HOST
+#define TL_STORAGE_EEPROM_SUPPORTED
+#define TL_HOST_EEPROM_SIZE				4096
+static uint8_t hostEEPROM[TL_HOST_EEPROM_SIZE];
+#endif
+
+uint16_t TLSnapshotChecksum(const uint8_t * buf, uint16_t length,
+	uint16_t sum)
+{
+	uint16_t sum1, sum2, n;
+
+	sum1 = sum & 0xFF;
+	sum2 = sum >> 8;
+	for (n = 0; n < length; n++) {
+		sum1 = (sum1 + buf[n]) % 255;
+		sum2 = (sum2 + sum1) % 255;
+	}
+
+	return (sum2 << 8) | sum1;
+}
+
+#if defined(TL_STORAGE_EEPROM_SUPPORTED)
+static int storageEEPROMRead(struct TLStorage * s, uint16_t address,
+	uint8_t * buf, uint16_t length)
+{
+	uint16_t n;
+
+	address += s->address;
+	for (n = 0; n < length; n++) {
+		#if IS_HOST
+		if (address + n >= TL_HOST_EEPROM_SIZE) {
+			return -1;
+		}
+		buf[n] = hostEEPROM[address + n];
+		#else
+		buf[n] = EEPROM.read(address + n);
+		#endif
+	}
+
+	return 0;
+}
+
+static int storageEEPROMWrite(struct TLStorage * s, uint16_t address,
+	const uint8_t * buf, uint16_t length)
+{
+	uint16_t n;
+
+	address += s->address;
+	for (n = 0; n < length; n++) {
+		#if IS_HOST
+		if (address + n >= TL_HOST_EEPROM_SIZE) {
+			return -1;
+		}
+		hostEEPROM[address + n] = buf[n];
+		#elif IS_AVR
+		/* Only write changed bytes to limit EEPROM wear */
+		EEPROM.update(address + n, buf[n]);
+		#else
+		EEPROM.write(address + n, buf[n]);
+		#endif
+	}
+
+	return 0;
+}
+
+static int storageEEPROMCommit(struct TLStorage * s)
+{
+	#if IS_ESP32
+	return EEPROM.commit() ? 0 : -1;
+	#else
+	return 0;
+	#endif
+}
+#endif
+
+int TLStorageEEPROMInit(struct TLStorage * s, uint16_t address)
+{
+	#if defined(TL_STORAGE_EEPROM_SUPPORTED)
+	s->read = storageEEPROMRead;
+	s->write = storageEEPROMWrite;
+	s->commit = storageEEPROMCommit;
+	s->address = address;
+	s->context = NULL;
+
+	return 0;
+	#else
+	s->read = NULL;
+	s->write = NULL;
+	s->commit = NULL;
+	s->address = address;
+	s->context = NULL;
+
+	return -1;
+	#endif
+}
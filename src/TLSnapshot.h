@@ -0,0 +1,116 @@
+/*
+ * TLSnapshot.h - Warm start snapshots for TouchLibrary for Arduino
+ * https://github.com/AdmarSchoonen/TLSensor
+ * Copyright (c) 2016, 2017 Admar Schoonen
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TLSnapshot_h
+#define TLSnapshot_h
+
+#include <stdint.h>
+
+/*
+ * Non-volatile storage used by TLSensors::saveSnapshot() and
+ * TLSensors::restoreSnapshot(). read and write transfer length bytes at address
+ * (relative to the start of the storage) and return 0 on success. commit is
+ * called after a snapshot has been written and may be NULL. context is free for
+ * use by the implementation.
+ *
+ * TLStorageEEPROMInit() sets up a storage that uses the Arduino EEPROM library
+ * (ATmega, Teensy 3.x / LC, ESP32 and Particle), starting at EEPROM address
+ * address. On ESP32, EEPROM.begin() must be called by the application with a
+ * size of at least address + the size of the snapshot. On the host, EEPROM is
+ * emulated in RAM. On other boards TLStorageEEPROMInit() returns -1.
+ */
+struct TLStorage {
+	int (*read)(struct TLStorage * s, uint16_t address, uint8_t * buf,
+		uint16_t length);
+	int (*write)(struct TLStorage * s, uint16_t address,
+		const uint8_t * buf, uint16_t length);
+	int (*commit)(struct TLStorage * s);
+	uint16_t address;
+	void * context;
+};
+
+int TLStorageEEPROMInit(struct TLStorage * s, uint16_t address);
+
+#define TL_SNAPSHOT_MAGIC				0x544C
+#define TL_SNAPSHOT_VERSION				2
+
+struct TLSnapshotHeader {
+	uint16_t magic;
+	uint8_t version;
+	uint8_t nSensors;
+	uint8_t nMeasurementsPerSensor;
+	uint8_t sizeOfSensor; /* sizeof(struct TLSnapshotSensor) */
+	uint16_t checksum; /* TLSnapshotChecksum() of all sensors */
+	uint16_t configChecksum; /* TLSnapshotChecksum() of all configs */
+	uint8_t reserved[2];
+};
+
+struct TLSnapshotSensor {
+	int32_t avg;
+	int32_t offsetValue;
+	uint32_t noisePower;
+	int32_t baselineState; /* tlStructBaselineMethod */
+	uint32_t nCharges; /* only if isCVD */
+	uint8_t isCalibrated;
+	uint8_t isCVD;
+	uint8_t reserved[2];
+};
+
+/*
+ * Configuration of a sensor that a snapshot depends on. Only its checksum is
+ * stored (configChecksum); a snapshot that was saved with another
+ * configuration (e.g. by a previous firmware with other pins or thresholds)
+ * is not restored.
+ */
+#define TL_SNAPSHOT_SAMPLE_METHOD_CUSTOM		0
+#define TL_SNAPSHOT_SAMPLE_METHOD_CVD			1
+#define TL_SNAPSHOT_SAMPLE_METHOD_RESISTIVE		2
+#define TL_SNAPSHOT_SAMPLE_METHOD_TOUCHREAD		3
+
+struct TLSnapshotConfig {
+	int32_t pin;
+	int32_t referenceValue;
+	int32_t scaleFactor;
+	int32_t releasedToApproachedThreshold;
+	int32_t approachedToReleasedThreshold;
+	int32_t approachedToPressedThreshold;
+	int32_t pressedToApproachedThreshold;
+	uint8_t sampleMethod; /* TL_SNAPSHOT_SAMPLE_METHOD_... */
+	uint8_t sampleType;
+	uint8_t direction;
+	uint8_t reserved;
+};
+
+/*
+ * Fletcher-16 checksum of length bytes of buf, continuing from sum (start with
+ * 0).
+ */
+uint16_t TLSnapshotChecksum(const uint8_t * buf, uint16_t length,
+	uint16_t sum);
+
+#endif
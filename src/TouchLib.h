@@ -36,22 +36,78 @@
 #include <TLSampleMethodResistive.h>
 #include <TLSampleMethodTouchRead.h>
 #include <TLCombSort.h>
+#include <TLMedian.h>
+#include <TLBitset.h>
+#include <TLScanOrder.h>
+#include <TLFastGpio.h>
+#include <TLBaselineMethod.h>
+#include <TLRunningMedian.h>
+#include <TLSnapshot.h>
 
 #if !(IS_ATMEGA)
 #define TL_ENABLE_MEDIAN_FILTER
 #define TL_ENABLE_LARGE_FILTER_BUF
+#define TL_ENABLE_TRIMMED_MEAN_FILTER
+#endif
+
+/*
+ * Maximum number of measurements that filterTypeTrimmedMean drops at each end
+ * (see filterTrim). Only used if TL_ENABLE_TRIMMED_MEAN_FILTER is defined
+ * (default on all boards except ATmega; define it before including TouchLib.h
+ * to enable it on ATmega).
+ */
+#if !defined(TL_TRIMMED_MEAN_TRIM_MAX)
+#define TL_TRIMMED_MEAN_TRIM_MAX		2
+#endif
+
+/*
+ * Maximum window length of the running median over scans (see
+ * runningMedianLength). Only used if TL_ENABLE_RUNNING_MEDIAN is defined before
+ * including TouchLib.h.
+ */
+#if !defined(TL_RUNNING_MEDIAN_LENGTH_MAX)
+#define TL_RUNNING_MEDIAN_LENGTH_MAX		32
+#endif
+
+/*
+ * Number of state change events that fit in the event queue (see getEvent()).
+ * Must be a power of 2, at most 128. Only used if TL_ENABLE_EVENT_QUEUE is
+ * defined before including TouchLib.h.
+ */
+#if !defined(TL_EVENT_QUEUE_LENGTH)
+#define TL_EVENT_QUEUE_LENGTH			16
+#endif
+
+#if defined(TL_ENABLE_EVENT_QUEUE)
+#if ((TL_EVENT_QUEUE_LENGTH) < 1) || ((TL_EVENT_QUEUE_LENGTH) > 128) || \
+	((TL_EVENT_QUEUE_LENGTH) & ((TL_EVENT_QUEUE_LENGTH) - 1))
+#error TL_EVENT_QUEUE_LENGTH must be a power of 2 and at most 128
+#endif
+#endif
+
+/*
+ * Orders the event queue accesses. ESP32 has two cores and needs a hardware
+ * barrier; on the other (single core) boards the queue is shared with
+ * interrupts or threads on the same core, for which a compiler barrier is
+ * enough.
+ */
+#if IS_ESP32
+#define TL_MEMORY_BARRIER()		__sync_synchronize()
+#else
+#define TL_MEMORY_BARRIER()		__asm__ __volatile__ ("" ::: "memory")
 #endif
 
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
 class TLSensors;
 
 struct TLStruct {
-	/* enum definitions */
-	enum ButtonState {
+	/* enum definitions; all enums are stored in a single byte */
+	enum ButtonState : uint8_t {
 		/*
 		 * Button states.
 		 * buttonStatePreCalibrating, buttonStateCalibrating,
-		 * buttonStateNoisePowerMeasurement, buttonStateReleased,
+		 * buttonStateNoisePowerMeasurement, buttonStateVerifying,
+		 * buttonStateReleased,
 		 * buttonStateReleasedToApproached, buttonStateApproached,
 		 * buttonStateApproachedToReleased and
 		 * buttonStateApproachedToPressed can be regarded as "released"
@@ -69,23 +125,27 @@ struct TLStruct {
 		 * equal to buttonStateApproachedToReleased as "approached".
 		 *
 		 * Additionally, button state smaller than or equal to
-		 * buttonStateNoisePowerMeasurement can be considered as
-		 * "calibrating".
+		 * buttonStateVerifying can be considered as "calibrating".
+		 *
+		 * buttonStateVerifying is only used after restoreSnapshot():
+		 * the first scan checks the restored avg against the measured
+		 * value.
 		 */
 		buttonStatePreCalibrating = 0,
 		buttonStateCalibrating = 1,
 		buttonStateNoisePowerMeasurement = 2,
-		buttonStateReleased = 3,
-		buttonStateReleasedToApproached = 4,
-		buttonStateApproached = 5,
-		buttonStateApproachedToPressed = 6,
-		buttonStateApproachedToReleased = 7,
-		buttonStatePressed = 8,
-		buttonStatePressedToApproached = 9,
-		buttonStateMax = 10
+		buttonStateVerifying = 3,
+		buttonStateReleased = 4,
+		buttonStateReleasedToApproached = 5,
+		buttonStateApproached = 6,
+		buttonStateApproachedToPressed = 7,
+		buttonStateApproachedToReleased = 8,
+		buttonStatePressed = 9,
+		buttonStatePressedToApproached = 10,
+		buttonStateMax = 11
 	};
 
-	enum Direction {
+	enum Direction : uint8_t {
 		/*
 		 * directionPositive means the value is increased when a
 		 * user touches the button (this is the default behaviour).
@@ -96,7 +156,7 @@ struct TLStruct {
 		directionPositive
 	};
 
-	enum SampleType {
+	enum SampleType : uint8_t {
 		/*
 		 * SampleType specifies the way samples are taken.
 		 * sampleTypeNormal means the sensor is first discharged and
@@ -120,7 +180,7 @@ struct TLStruct {
 		sampleTypeDifferential = 3
 	};
 
-	enum FilterType {
+	enum FilterType : uint8_t {
 		/*
 		 * filterTypeAverage uses a simple average filter (summation)
 		 *   pro: no reduction in signal strength
@@ -138,13 +198,45 @@ struct TLStruct {
 		 *   pro: no reduction in signal strength, not sensitive to
 		 *     spikes
 		 *   con: requires a buffer with size N_MEASUREMENTS_PER_SENSOR
+		 *
+		 * filterTypeIIR uses a single pole IIR (exponential) filter
+		 *   with coefficient 1 / 2^filterIIRShift that keeps its state
+		 *   across scans
+		 *   pro: no buffer, similar noise rejection as
+		 *     filterTypeAverage with fewer measurements per scan (and
+		 *     thus shorter scan times)
+		 *   con: slower response; a change in capacitance takes about
+		 *     2^filterIIRShift measurements to settle
+		 *
+		 * filterTypeMedian3 uses a median filter over each 3
+		 *   consecutive measurements, followed by an average filter
+		 *   (summation)
+		 *   pro: no buffer (works on ATmega), no reduction in signal
+		 *     strength, rejects spikes of a single measurement (also
+		 *     at the first or last measurement)
+		 *   con: sensitive to spikes lasting 2 or more consecutive
+		 *     measurements; requires at least 3 measurements per
+		 *     sensor (falls back to filterTypeAverage if not)
+		 *
+		 * filterTypeTrimmedMean uses an average filter (summation) in
+		 *   which the filterTrim highest and filterTrim lowest
+		 *   measurements are replaced by the nearest remaining
+		 *   measurement (winsorized mean)
+		 *   pro: hardly any reduction in signal strength, rejects up to
+		 *     filterTrim spikes per scan in each direction, no sorting
+		 *     and no division
+		 *   con: requires a buffer of 2 * (TL_TRIMMED_MEAN_TRIM_MAX +
+		 *     1) values per sensor (disabled on ATmega by default)
 		 */
 		filterTypeAverage = 0,
 		filterTypeSlewrateLimiter,
-		filterTypeMedian
+		filterTypeMedian,
+		filterTypeIIR,
+		filterTypeMedian3,
+		filterTypeTrimmedMean
 	};
 
-	enum WaterRejectMode {
+	enum WaterRejectMode : uint8_t {
 		waterRejectModeFloat = 0,
 		waterRejectModeGnd,
 		waterRejectModeVdd,
@@ -152,6 +244,21 @@ struct TLStruct {
 		waterRejectModeDiff
 	};
 
+	enum ConfigStorage : uint8_t {
+		/*
+		 * Storage of the configuration that config points to.
+		 * configStorageRam is RAM that may be changed (default),
+		 * configStorageConst is a const configuration and
+		 * configStorageFlash is a const configuration that is stored
+		 * with TL_CONFIG_ATTR (PROGMEM on AVR, where it must be read
+		 * with pgm_read_...(); the same as configStorageConst on the
+		 * other boards).
+		 */
+		configStorageRam = 0,
+		configStorageConst,
+		configStorageFlash
+	};
+
 	struct FilterParamsAverage {
 	};
 
@@ -165,12 +272,52 @@ struct TLStruct {
 	};
 	#endif
 
-	union TLStructSampleMethod {
-		struct TLStructSampleMethodCVD CVD;
-		struct TLStructSampleMethodResistive resistive;
-		struct TLStructSampleMethodTouchRead touchRead;
-		struct TLStructSampleMethodCustom custom;
-	} tlStructSampleMethod;
+	struct FilterParamsIIR {
+		int32_t state; /* filter output << filterIIRShift */
+		bool primed;
+	};
+
+	struct FilterParamsMedian3 {
+		int32_t prev[2]; /* previous 2 measurements */
+		uint8_t idx;
+	};
+
+	struct FilterParamsTrimmedMean {
+		uint8_t idx;
+	};
+
+	/*
+	 * Runtime state that is used in every scan. It is placed first and
+	 * ordered by size, so that it packs without padding and most of it is
+	 * within the first 64 bytes of the struct. On ATmega, these members
+	 * can then be accessed through a TLStruct pointer with displacement
+	 * addressing (ldd / std), which is limited to offsets up to 63.
+	 * These members will be set by the init / sample methods.
+	 */
+	int32_t raw;
+	/* Total value in pico Farad (pF) */
+	int32_t value;
+	int32_t avg;
+	int32_t delta;
+	uint32_t noisePower;
+	unsigned long lastSampledAtTime;
+	unsigned long stateChangedAtTime;
+	uint16_t counter; /* at most filterCoeff - 1 */
+	uint16_t noiseCounter; /* at most filterCoeff - 1 */
+	uint16_t measurementAcc;
+	enum ButtonState buttonState;
+	uint8_t nMeasurementsPerSensor;
+	bool scanActive; /* sensor is measured in current scan */
+	bool stateIsBeingChanged;
+	bool forcedCal;
+
+	/*
+	 * Set disableSensor to true for dummy sensors or sensors that are not
+	 * used. Disabled sensors are not measured, not processed and ignored
+	 * by the anyButtonIs...() functions. When a sensor is enabled again, it
+	 * is recalibrated.
+	 */
+	bool disableSensor;
 
 	union FilterParams {
 		struct FilterParamsAverage average;
@@ -178,16 +325,78 @@ struct TLStruct {
 		#if defined(TL_ENABLE_MEDIAN_FILTER)
 		struct FilterParamsMedian median;
 		#endif
+		struct FilterParamsIIR iir;
+		struct FilterParamsMedian3 median3;
+		struct FilterParamsTrimmedMean trimmedMean;
 	} filterParams;
 
+	union TLStructBaselineMethod {
+		struct TLStructBaselineMethodEMA ema;
+		struct TLStructBaselineMethodWelford welford;
+	} tlStructBaselineMethod;
+
 	/*
-	 * These members are set to defaults upon initialization but can be
-	 * overruled by the user.
+	 * Configuration of this sensor (see struct TLStructConfig). By default
+	 * this is the configuration in RAM that TLSensors::config() returns;
+	 * TLSensors::setConfig() can select a const configuration instead,
+	 * which may be shared by several sensors and may be stored in flash.
+	 * Read its members with TL_CONFIG(). Set by the library.
 	 */
-	enum Direction direction;
-	enum SampleType sampleType;
-	int * pin;
-	int waterRejectPin; /* set to -1 to disable */
+	const struct TLStructConfig * config;
+	enum ConfigStorage configStorage;
+
+	/* Runtime state that is not used in every scan */
+	union TLStructSampleMethodState {
+		struct TLStructSampleMethodCVDState CVD;
+	} tlStructSampleMethodState;
+
+	struct TLFastPin waterRejectFastPin; /* set by the library */
+
+	/*
+	 * In pico Farad (pF). Set to avg after calibration, unless
+	 * setOffsetValueManually is set in the configuration.
+	 */
+	int32_t offsetValue;
+	int32_t maxDelta;
+	const char * buttonStateLabel; /* human readable label */
+	bool buttonIsCalibrating; /* use this to see if button is calibrating */
+	bool buttonIsReleased; /* use this to see if button is released */
+	bool buttonIsApproached; /* use this to see if button is approached */
+	bool buttonIsPressed; /* use this to see if button is pressed */
+	uint8_t nSensors;
+	uint8_t runningMedianN;
+	uint16_t adaptiveHoldCounter; /* at most filterCoeff */
+	bool disableSensorPrev; /* set by the library */
+	enum FilterType filterTypePrev; /* set by the library */
+};
+
+/*
+ * Configuration of a sensor. It is not changed by the library during scans, so
+ * it can be const and can be stored in flash (see TLSensors::setConfig()). A
+ * configuration in RAM is set to defaults upon initialization but can be
+ * overruled by the user.
+ */
+struct TLStructConfig {
+	union TLStructSampleMethod {
+		struct TLStructSampleMethodCVD CVD;
+		struct TLStructSampleMethodResistive resistive;
+		struct TLStructSampleMethodTouchRead touchRead;
+		struct TLStructSampleMethodCustom custom;
+
+		/* Members can be selected in constant initializers */
+		TLStructSampleMethod() = default;
+		constexpr TLStructSampleMethod(
+			struct TLStructSampleMethodCVD m) : CVD(m) { }
+		constexpr TLStructSampleMethod(
+			struct TLStructSampleMethodResistive m) :
+			resistive(m) { }
+		constexpr TLStructSampleMethod(
+			struct TLStructSampleMethodTouchRead m) :
+			touchRead(m) { }
+		constexpr TLStructSampleMethod(
+			struct TLStructSampleMethodCustom m) : custom(m) { }
+	} tlStructSampleMethod;
+
 	int32_t releasedToApproachedThreshold;
 	int32_t approachedToReleasedThreshold;
 	int32_t approachedToPressedThreshold;
@@ -197,23 +406,13 @@ struct TLStruct {
 	uint32_t approachedToReleasedTime;
 	uint32_t approachedToPressedTime;
 	uint32_t pressedToApproachedTime;
-	enum FilterType filterType;
-	enum WaterRejectMode waterRejectMode;
 	unsigned long preCalibrationTime;
 	unsigned long calibrationTime;
 	unsigned long approachedTimeout;
 	unsigned long pressedTimeout;
-	uint16_t filterCoeff;
-	uint32_t forceCalibrationWhenReleasingFromApproached;
-	uint32_t forceCalibrationWhenApproachingFromReleased;
-	uint32_t forceCalibrationWhenApproachingFromPressed;
-	uint32_t forceCalibrationWhenPressing;
-	bool setOffsetValueManually;
-	bool disableUpdateIfAnyButtonIsApproached;
-	bool disableUpdateIfAnyButtonIsPressed;
 	int32_t referenceValue; /* in pico Farad (pF) */
-	int32_t offsetValue; /* in pico Farad (pF) */
 	int32_t scaleFactor;
+	int waterRejectPin; /* set to -1 to disable */
 
 	/* 
 	 * sampleMethod can be set to:
@@ -228,6 +427,16 @@ struct TLStruct {
 	 */
 	int (*sampleMethod)(struct TLStruct * d, uint8_t nSensors, uint8_t ch);
 
+	/*
+	 * baselineMethod updates avg and noisePower (see TLBaselineMethod.h)
+	 * and can be set to:
+	 * - TLBaselineMethodAverage (default)
+	 * - TLBaselineMethodEMA
+	 * - TLBaselineMethodWelford
+	 * - custom method
+	 */
+	void (*baselineMethod)(struct TLStruct * d, bool updateNoisePower);
+
 	/*
 	 * sampleMethodPreSample should be set by sampleMethod. It is called at
 	 * the beginning of a new measurement.
@@ -258,6 +467,26 @@ struct TLStruct {
 	int32_t (*sampleMethodMapDelta)(struct TLStruct * d, uint8_t nSensors,
 		uint8_t ch, int length);
 
+	uint16_t filterCoeff;
+	enum TLStruct::Direction direction;
+	enum TLStruct::SampleType sampleType;
+	enum TLStruct::FilterType filterType;
+	enum TLStruct::WaterRejectMode waterRejectMode;
+	uint8_t filterIIRShift; /* at most TL_FILTER_IIR_SHIFT_MAX */
+	uint8_t filterTrim; /* at most TL_TRIMMED_MEAN_TRIM_MAX */
+
+	/*
+	 * Number of scans over which value is median filtered, to suppress
+	 * spikes that last a few scans (ESD, switching relays). Requires
+	 * TL_ENABLE_RUNNING_MEDIAN; values of 0 and 1 disable the filter.
+	 * Limited to TL_RUNNING_MEDIAN_LENGTH_MAX.
+	 */
+	uint8_t runningMedianLength;
+	uint8_t minMeasurementsPerSensor; /* see enableAdaptiveMeasurements */
+	bool setOffsetValueManually;
+	bool disableUpdateIfAnyButtonIsApproached;
+	bool disableUpdateIfAnyButtonIsPressed;
+
 	/*
 	 * Set enableTouchStateMachine to false to only use a sensor for
 	 * capacitive sensing or during tuning. After startup, sensor will be in
@@ -273,30 +502,268 @@ struct TLStruct {
 	 */
 	bool enableNoisePowerMeasurement;
 
-	/* These members will be set by the init / sample methods. */
-	uint8_t nSensors;
-	uint8_t nMeasurementsPerSensor;
-	int32_t raw;
-	/* Total value in pico Farad (pF) */
-	int32_t value;
-	int32_t avg;
+	/*
+	 * Set enableAdaptiveMeasurements to true to let nMeasurementsPerSensor
+	 * of this sensor adapt to its noise power. In state
+	 * buttonStateReleased it is halved (down to minMeasurementsPerSensor)
+	 * while TL_ADAPTIVE_MEASUREMENTS_NOISE_MARGIN times the noise level is
+	 * well below approachedToReleasedThreshold, and doubled (up to
+	 * N_MEASUREMENTS_PER_SENSOR) when it is above. In all other states
+	 * N_MEASUREMENTS_PER_SENSOR measurements are used. Skipped positions in
+	 * scanOrder are spread evenly over the scan. Requires
+	 * enableNoisePowerMeasurement; not supported with filterTypeMedian.
+	 */
+	bool enableAdaptiveMeasurements;
+};
+
+struct TLStateChangeEvent {
+	uint8_t ch;
+	enum TLStruct::ButtonState oldState;
+	enum TLStruct::ButtonState newState;
+	unsigned long time; /* lastSampledAtTime of the sensor */
 	int32_t delta;
-	int32_t maxDelta;
-	uint32_t noisePower;
-	enum ButtonState buttonState;
-	const char * buttonStateLabel; /* human readable label */
-	bool buttonIsCalibrating; /* use this to see if button is calibrating */
-	bool buttonIsReleased; /* use this to see if button is released */
-	bool buttonIsApproached; /* use this to see if button is approached */
-	bool buttonIsPressed; /* use this to see if button is pressed */
-	bool forcedCal;
-	uint32_t counter;
-	uint32_t noiseCounter;
-	uint32_t recalCounter;
-	unsigned long lastSampledAtTime;
-	unsigned long stateChangedAtTime;
-	bool stateIsBeingChanged;
-	bool disableSensor; /* set to true for dummy sensors */
+};
+
+/*
+ * TL_CONFIG(d, member) reads member of the configuration of sensor d (a struct
+ * TLStruct *), for example TL_CONFIG(d, filterType) or TL_CONFIG(d,
+ * tlStructSampleMethod.CVD.pin). On AVR, flash is not in the address space of
+ * RAM and a configuration with configStorageFlash is read with
+ * pgm_read_...(); on the other boards this is (d)->config->member.
+ *
+ * Declare configurations that are stored in flash with TL_CONFIG_ATTR.
+ */
+#if IS_AVR
+#define TL_CONFIG_ATTR					PROGMEM
+
+template <class T, size_t SIZE = sizeof(T)>
+struct TLConfigFlash {
+	static T read(const T * p)
+	{
+		T v;
+
+		memcpy_P(&v, p, sizeof(T));
+
+		return v;
+	}
+};
+
+template <class T>
+struct TLConfigFlash<T, 1> {
+	static T read(const T * p)
+	{
+		uint8_t b = pgm_read_byte(p);
+		T v;
+
+		memcpy(&v, &b, sizeof(T));
+
+		return v;
+	}
+};
+
+template <class T>
+struct TLConfigFlash<T, 2> {
+	static T read(const T * p)
+	{
+		uint16_t w = pgm_read_word(p);
+		T v;
+
+		memcpy(&v, &w, sizeof(T));
+
+		return v;
+	}
+};
+
+template <class T>
+struct TLConfigFlash<T, 4> {
+	static T read(const T * p)
+	{
+		uint32_t w = pgm_read_dword(p);
+		T v;
+
+		memcpy(&v, &w, sizeof(T));
+
+		return v;
+	}
+};
+
+template <class T>
+static inline T TLConfigRead(const T * p, enum TLStruct::ConfigStorage storage)
+{
+	return (storage == TLStruct::configStorageFlash) ?
+		TLConfigFlash<T>::read(p) : *p;
+}
+
+#define TL_CONFIG(d, member)				\
+	TLConfigRead(&((d)->config->member), (d)->configStorage)
+#else
+#define TL_CONFIG_ATTR
+#define TL_CONFIG(d, member)				((d)->config->member)
+#endif
+
+/* Configuration of sensor d that may be changed, or NULL if it is const */
+static inline struct TLStructConfig * TLConfigWritable(struct TLStruct * d)
+{
+	return (d->configStorage == TLStruct::configStorageRam) ?
+		const_cast<struct TLStructConfig *>(d->config) : NULL;
+}
+
+/* Pin of sensor d; pin is the first member of all sample method structs */
+static inline int TLConfigPin(struct TLStruct * d)
+{
+	return TL_CONFIG(d, tlStructSampleMethod.custom.pin);
+}
+
+#define TL_RELEASED_TO_APPROACHED_TIME_DEFAULT			10
+#define TL_APPROACHED_TO_RELEASED_TIME_DEFAULT			10
+#define TL_APPROACHED_TO_PRESSED_TIME_DEFAULT			10
+#define TL_PRESSED_TO_APPROACHED_TIME_DEFAULT			10
+#define TL_PRE_CALIBRATION_TIME_DEFAULT				100
+#define TL_CALIBRATION_TIME_DEFAULT				500
+#define TL_FILTER_COEFF_DEFAULT					16
+#define TL_FILTER_IIR_SHIFT_DEFAULT				3
+/* Larger values of filterIIRShift are clamped (state << shift must fit) */
+#define TL_FILTER_IIR_SHIFT_MAX					8
+#define TL_FILTER_TRIM_DEFAULT					1
+#define TL_RUNNING_MEDIAN_LENGTH_DEFAULT			0
+#define TL_APPROACHED_TIMEOUT_DEFAULT				300000
+#define TL_PRESSED_TIMEOUT_DEFAULT				TL_APPROACHED_TIMEOUT_DEFAULT
+#define TL_FORCE_CALIBRATION_WHEN_RELEASING_FROM_APPROACHED_DEFAULT	0
+#define TL_FORCE_CALIBRATION_WHEN_APPROACHING_FROM_RELEASED_DEFAULT	0
+#define TL_FORCE_CALIBRATION_WHEN_APPROACHING_FROM_PRESSED_DEFAULT	0
+#define TL_FORCE_CALIBRATION_WHEN_PRESSING_DEFAULT		0
+
+#define TL_ENABLE_TOUCH_STATE_MACHINE_DEFAULT			true
+#define TL_ENABLE_NOISE_POWER_MEASUREMENT_DEFAULT		false
+#define TL_ENABLE_ADAPTIVE_MEASUREMENTS_DEFAULT			false
+#define TL_MIN_MEASUREMENTS_PER_SENSOR_DEFAULT			4
+#define TL_ADAPTIVE_MEASUREMENTS_NOISE_MARGIN			3
+
+#define TL_DISABLE_UPDATE_IF_ANY_BUTTON_IS_APPROACHED_DEFAULT	false
+#define TL_DISABLE_UPDATE_IF_ANY_BUTTON_IS_PRESSED_DEFAULT	false
+
+#define TL_SAMPLE_METHOD_DEFAULT				(&TLSampleMethodCVD)
+#define TL_BASELINE_METHOD_DEFAULT				(&TLBaselineMethodAverage)
+
+/*
+ * Configuration with the defaults of the library and the given sample method
+ * settings, for constant initializers of configurations (see
+ * TLSensors::setConfig()). The sample methods provide shorthands, such as
+ * TLSampleMethodCVDConfig().
+ */
+constexpr struct TLStructConfig TLStructConfigMake(
+		union TLStructConfig::TLStructSampleMethod method,
+		int (*sampleMethod)(struct TLStruct * d, uint8_t nSensors,
+		uint8_t ch),
+		int (*sampleMethodPreSample)(struct TLStruct * d,
+		uint8_t nSensors, uint8_t ch),
+		int32_t (*sampleMethodSample)(struct TLStruct * d,
+		uint8_t nSensors, uint8_t ch, bool inv),
+		int (*sampleMethodPostSample)(struct TLStruct * d,
+		uint8_t nSensors, uint8_t ch),
+		int32_t (*sampleMethodMapDelta)(struct TLStruct * d,
+		uint8_t nSensors, uint8_t ch, int length),
+		int32_t referenceValue, int32_t scaleFactor,
+		int32_t releasedToApproachedThreshold,
+		int32_t approachedToReleasedThreshold,
+		int32_t approachedToPressedThreshold,
+		int32_t pressedToApproachedThreshold,
+		enum TLStruct::Direction direction,
+		enum TLStruct::SampleType sampleType)
+{
+	return {
+		method,
+		releasedToApproachedThreshold,
+		approachedToReleasedThreshold,
+		approachedToPressedThreshold,
+		pressedToApproachedThreshold,
+		0, /* calibratedMaxDelta */
+		TL_RELEASED_TO_APPROACHED_TIME_DEFAULT,
+		TL_APPROACHED_TO_RELEASED_TIME_DEFAULT,
+		TL_APPROACHED_TO_PRESSED_TIME_DEFAULT,
+		TL_PRESSED_TO_APPROACHED_TIME_DEFAULT,
+		TL_PRE_CALIBRATION_TIME_DEFAULT,
+		TL_CALIBRATION_TIME_DEFAULT,
+		TL_APPROACHED_TIMEOUT_DEFAULT,
+		TL_PRESSED_TIMEOUT_DEFAULT,
+		referenceValue,
+		scaleFactor,
+		-1, /* waterRejectPin */
+		sampleMethod,
+		TL_BASELINE_METHOD_DEFAULT,
+		sampleMethodPreSample,
+		sampleMethodSample,
+		sampleMethodPostSample,
+		sampleMethodMapDelta,
+		TL_FILTER_COEFF_DEFAULT,
+		direction,
+		sampleType,
+		TLStruct::filterTypeAverage,
+		TLStruct::waterRejectModeFloat,
+		TL_FILTER_IIR_SHIFT_DEFAULT,
+		TL_FILTER_TRIM_DEFAULT,
+		TL_RUNNING_MEDIAN_LENGTH_DEFAULT,
+		TL_MIN_MEASUREMENTS_PER_SENSOR_DEFAULT,
+		false, /* setOffsetValueManually */
+		TL_DISABLE_UPDATE_IF_ANY_BUTTON_IS_APPROACHED_DEFAULT,
+		TL_DISABLE_UPDATE_IF_ANY_BUTTON_IS_PRESSED_DEFAULT,
+		TL_ENABLE_TOUCH_STATE_MACHINE_DEFAULT,
+		TL_ENABLE_NOISE_POWER_MEASUREMENT_DEFAULT,
+		TL_ENABLE_ADAPTIVE_MEASUREMENTS_DEFAULT
+	};
+}
+
+/*
+ * Copy the members that a sample method sets upon initialization from m to c:
+ * the sample method settings of TLStructConfigMake(), filterType,
+ * waterRejectPin, waterRejectMode and setOffsetValueManually. The other
+ * members of c are not changed.
+ */
+static inline void TLConfigSetSampleMethod(struct TLStructConfig * c,
+		const struct TLStructConfig * m)
+{
+	c->tlStructSampleMethod = m->tlStructSampleMethod;
+	c->sampleMethodPreSample = m->sampleMethodPreSample;
+	c->sampleMethodSample = m->sampleMethodSample;
+	c->sampleMethodPostSample = m->sampleMethodPostSample;
+	c->sampleMethodMapDelta = m->sampleMethodMapDelta;
+	c->referenceValue = m->referenceValue;
+	c->scaleFactor = m->scaleFactor;
+	c->setOffsetValueManually = m->setOffsetValueManually;
+	c->releasedToApproachedThreshold = m->releasedToApproachedThreshold;
+	c->approachedToReleasedThreshold = m->approachedToReleasedThreshold;
+	c->approachedToPressedThreshold = m->approachedToPressedThreshold;
+	c->pressedToApproachedThreshold = m->pressedToApproachedThreshold;
+	c->direction = m->direction;
+	c->sampleType = m->sampleType;
+	c->filterType = m->filterType;
+	c->waterRejectPin = m->waterRejectPin;
+	c->waterRejectMode = m->waterRejectMode;
+}
+
+#include <TLSampleMethodCVDInline.h>
+#include <TLSampleMethodResistiveInline.h>
+#include <TLSampleMethodTouchReadInline.h>
+
+/*
+ * Default configurations of N_SENSORS sensors: TLSampleMethodCVD on pins A0,
+ * A1, ... with the defaults of the library. Generated at compile time and
+ * stored in flash; used if TL_ENABLE_CONST_CONFIG is defined (see
+ * TLSensors::setConfig()).
+ */
+template <uint8_t N_SENSORS, class INDICES =
+	typename TLMakeIndexList<N_SENSORS>::type>
+struct TLConfigDefaultTable;
+
+template <uint8_t N_SENSORS, uint16_t... I>
+struct TLConfigDefaultTable<N_SENSORS, TLIndexList<I...> > {
+	static const struct TLStructConfig table[sizeof...(I)];
+};
+
+template <uint8_t N_SENSORS, uint16_t... I>
+const struct TLStructConfig TLConfigDefaultTable<N_SENSORS,
+		TLIndexList<I...> >::table[sizeof...(I)] TL_CONFIG_ATTR = {
+	TLSampleMethodCVDConfig(A0 + I)...
 };
 
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
@@ -305,16 +772,6 @@ class TLSensors
 	public:
 		struct TLStruct data[N_SENSORS];
 		uint8_t nSensors;
-
-		/*
-		 * Ideally scanOrder would be a static const uint8_t array the
-		 * size of nSensors * nMeasurementPerSensor with a pseudo random
-		 * sequence generated by the C preprocessor. I just don't know
-		 * how to do this (or if it is possible at all). For now, we'll
-		 * just use RAM and initialize it at start up, wasting some
-		 * precious RAM space.
-		 */
-		uint8_t scanOrder[N_SENSORS * N_MEASUREMENTS_PER_SENSOR];
 		uint8_t	nMeasurementsPerSensor;
 		int8_t error;
 		#if defined(TL_ENABLE_LARGE_FILTER_BUF)
@@ -322,16 +779,134 @@ class TLSensors
 		#else
 		int32_t filterBuf[N_SENSORS][1];
 		#endif
+		#if defined(TL_ENABLE_BACKGROUND_SCAN)
+		uint16_t backgroundBuf[N_SENSORS * N_MEASUREMENTS_PER_SENSOR][2];
+		#endif
+		#if defined(TL_ENABLE_TRIMMED_MEAN_FILTER)
+		/* Highest and lowest measurements, sorted from the outside in */
+		int32_t trimBufHigh[N_SENSORS][TL_TRIMMED_MEAN_TRIM_MAX + 1];
+		int32_t trimBufLow[N_SENSORS][TL_TRIMMED_MEAN_TRIM_MAX + 1];
+		#endif
+		/*
+		 * forceCalibrationWhen...[ch] is the set of sensors that is
+		 * recalibrated when sensor ch makes the corresponding state
+		 * change. Set element k with
+		 * forceCalibrationWhenPressing[ch].set(k).
+		 */
+		TLBitset<N_SENSORS>
+			forceCalibrationWhenReleasingFromApproached[N_SENSORS];
+		TLBitset<N_SENSORS>
+			forceCalibrationWhenApproachingFromReleased[N_SENSORS];
+		TLBitset<N_SENSORS>
+			forceCalibrationWhenApproachingFromPressed[N_SENSORS];
+		TLBitset<N_SENSORS> forceCalibrationWhenPressing[N_SENSORS];
+
+		#if defined(TL_ENABLE_EVENT_QUEUE)
+		/*
+		 * Number of events that were dropped because the queue was
+		 * full, and the maximum number of events that were queued.
+		 * Both are only written by the scan (producer).
+		 */
+		volatile uint32_t eventsDropped;
+		volatile uint8_t eventsMaxQueued;
+		#endif
+		#if defined(TL_ENABLE_RUNNING_MEDIAN)
+		int32_t runningMedianBuf[N_SENSORS][TL_RUNNING_MEDIAN_LENGTH_MAX];
+		uint8_t runningMedianAge[N_SENSORS][TL_RUNNING_MEDIAN_LENGTH_MAX];
+		#endif
 
 		int8_t setDefaults(void);
 		int initialize(uint8_t ch, int (*sampleMethod)(
 			struct TLStruct * d, uint8_t nSensors, uint8_t ch));
+
+		/*
+		 * The configuration of sensor ch (thresholds, times, sample
+		 * method, filter, ...) is not stored in data[ch] but in a
+		 * struct TLStructConfig that data[ch].config points to, so
+		 * that the scan only touches the state of the sensors.
+		 * config(ch) is the configuration of sensor ch that may be
+		 * changed, for example config(ch).pressedThreshold = 20.
+		 *
+		 * setConfig() makes sensor ch use configuration c instead,
+		 * for example a const table (TL_CONFIG_ATTR if inFlash) that
+		 * is built with TLSampleMethodCVDConfig() and
+		 * TLStructConfigMake(); setConfigTable() does the same for
+		 * all sensors with table[0 ... nSensors - 1]. c or table is
+		 * NULL to return to the default configuration. The sensor is
+		 * recalibrated. A const configuration can't be changed with
+		 * config(ch) or initialize(); initialize() only accepts the
+		 * sample method of the configuration.
+		 *
+		 * If TL_ENABLE_CONST_CONFIG is defined, there is no
+		 * configuration in RAM and config(ch) doesn't exist; the
+		 * default configuration of sensor ch is
+		 * TLSampleMethodCVDConfig(A0 + ch) in flash.
+		 */
+		#if !defined(TL_ENABLE_CONST_CONFIG)
+		struct TLStructConfig & config(uint8_t ch);
+		#endif
+		int setConfig(uint8_t ch, const struct TLStructConfig * c,
+			bool inFlash = false);
+		int setConfigTable(const struct TLStructConfig * table,
+			bool inFlash = false);
 		int8_t sample(void);
+
+		/*
+		 * Scan a subset of the sensors: only sensors 0 to
+		 * nSensorsToScan - 1, or the sensors in mask (if mask is a
+		 * uint32_t, sensors 32 and up are always scanned). Sensors keep
+		 * their position in scanOrder, so the interleave of the
+		 * scanned sensors does not change. Sensors that are not
+		 * scanned keep their state, avg and value. If freezeSkipped is
+		 * true, the time spent in their current state is frozen so that
+		 * they do not time out; if false (used by TLScanScheduler for
+		 * sensors that are sampled at a lower rate), state machine
+		 * timing continues in real time.
+		 */
 		int8_t sample(uint8_t nSensorsToScan);
+		int8_t sampleChannels(uint32_t mask, bool freezeSkipped = true);
+		int8_t sampleChannels(const TLBitset<N_SENSORS> & mask,
+			bool freezeSkipped = true);
+
+		/*
+		 * Non-blocking alternative for sample(). beginScan() starts a
+		 * new scan, after which step() must be called repeatedly until
+		 * scanComplete() returns true. Each call to step() performs at
+		 * most maxPositions units of work, where a unit is the
+		 * pre-sample of one sensor, the measurement at one position in
+		 * scanOrder or the post-sample and processing of one sensor.
+		 * This bounds the time spent in a single call. Results are
+		 * identical to those of sample(). Calling beginScan() while a
+		 * scan is in progress aborts that scan.
+		 *
+		 * If TL_ENABLE_BACKGROUND_SCAN is defined before including
+		 * TouchLib.h and the board supports it (ATmega and Teensy 3.x,
+		 * with the library built with TL_ENABLE_ADC_ISR, and the
+		 * host), the measurements of a CVD only configuration are
+		 * performed in the background by the ADC conversion complete
+		 * interrupt(s); the host completes them when step() polls.
+		 * On Teensy 3.2 with ADC1 two positions are measured
+		 * simultaneously. step() then only processes positions that
+		 * have been measured and never waits for the ADC. Sensors that
+		 * are not in mask or disabled and positions skipped because of
+		 * adaptive measurement counts are skipped by the background
+		 * scan as well; the positions to measure are then selected in
+		 * the first call of step() after the pre-sample stage. If any
+		 * sensor uses another sample method or a water reject pin, the
+		 * scan is done in the foreground. This requires 4 bytes of RAM
+		 * per position in scanOrder.
+		 */
+		int8_t beginScan(void);
+		int8_t beginScan(uint32_t mask, bool freezeSkipped = true);
+		int8_t beginScan(const TLBitset<N_SENSORS> & mask,
+			bool freezeSkipped = true);
+		int8_t step(uint16_t maxPositions);
+		bool scanComplete(void);
 		int findSensorPair(uint8_t ch, uint8_t chStart);
 		int printBar(uint8_t ch_k, int length);
 		void printScanOrder(void);
-		bool setForceCalibratingStates(int ch, uint32_t mask,
+		bool setForceCalibratingStates(int ch,
+			const TLBitset<N_SENSORS> & mask,
 			enum TLStruct::ButtonState * newState);
 		uint32_t getRaw(int n);
 		int32_t getValue(int n);
@@ -345,6 +920,19 @@ class TLSensors
 		bool anyButtonIsReleased(void);
 		bool anyButtonIsApproached(void);
 		bool anyButtonIsPressed(void);
+
+		/*
+		 * Sets of the sensors that are calibrating, released,
+		 * approached and pressed (same definitions as buttonIs...() in
+		 * TLStruct). Unlike buttonIs...(), which are updated at the end
+		 * of each scan, these are updated by setState() as soon as a
+		 * state changes. Disabled sensors are not in any set; a change
+		 * of disableSensor takes effect at the start of the next scan.
+		 */
+		const TLBitset<N_SENSORS> & getCalibratingSensors(void);
+		const TLBitset<N_SENSORS> & getReleasedSensors(void);
+		const TLBitset<N_SENSORS> & getApproachedSensors(void);
+		const TLBitset<N_SENSORS> & getPressedSensors(void);
 		int getSensorWithLargestDelta(void);
 		const char * getStateLabel(int n);
 		enum TLStruct::ButtonState getState(int n);
@@ -352,8 +940,66 @@ class TLSensors
 			enum TLStruct::ButtonState newState);
 		void setState(int n, enum TLStruct::ButtonState newState);
 		TLSensors(void);
+		TLSensors(const uint8_t * customScanOrder);
 		~TLSensors(void);
 
+		/*
+		 * By default, sensors are measured in the order of
+		 * TLScanOrderTable (see TLScanOrder.h), which is generated at
+		 * compile time and stored in flash. setScanOrder() selects a
+		 * custom scan order instead: an array of N_SENSORS *
+		 * N_MEASUREMENTS_PER_SENSOR channels in RAM, in which each
+		 * channel must occur N_MEASUREMENTS_PER_SENSOR times. The
+		 * array is not copied and must stay valid. Passing NULL
+		 * selects the default scan order again. Call this only when
+		 * no scan is in progress. getScanOrder() returns the channel
+		 * at position idx of the scan order in use.
+		 */
+		void setScanOrder(const uint8_t * customScanOrder);
+		uint8_t getScanOrder(uint16_t idx);
+
+		/*
+		 * Warm start. saveSnapshot() writes avg, offsetValue,
+		 * noisePower, the state of the baseline method and nCharges
+		 * (CVD only) of all sensors to storage (see TLSnapshot.h),
+		 * together with a checksum of their configuration (sample
+		 * method, pin, sampleType, direction, referenceValue,
+		 * scaleFactor and thresholds); only sensors that have finished
+		 * calibration are marked as valid. EEPROM wears out, so save
+		 * occasionally (for example before going to sleep), not every
+		 * scan.
+		 *
+		 * restoreSnapshot() reads a snapshot that was saved by a
+		 * TLSensors with the same N_SENSORS, N_MEASUREMENTS_PER_SENSOR
+		 * and configuration; a snapshot of another configuration is
+		 * rejected. Call it after configuring the sensors and before
+		 * the first scan. Restored sensors skip
+		 * calibration and start in buttonStateVerifying: if the first
+		 * scan measures a value within releasedToApproachedThreshold
+		 * of the restored avg, the sensor is released right away,
+		 * otherwise it is calibrated as usual. Returns the number of
+		 * restored sensors, or -1 if storage does not hold a valid
+		 * snapshot for this configuration.
+		 */
+		int8_t saveSnapshot(struct TLStorage * storage);
+		int restoreSnapshot(struct TLStorage * storage);
+
+		/*
+		 * If TL_ENABLE_EVENT_QUEUE is defined before including
+		 * TouchLib.h, every state change that would call
+		 * buttonStateChangeCallback is also stored in a queue of
+		 * TL_EVENT_QUEUE_LENGTH events. getEvent() takes the oldest
+		 * event from the queue; it returns false if the queue is
+		 * empty. The queue is lock free for a single producer (the
+		 * scan) and a single consumer (the caller of getEvent()), so
+		 * events can be handled in another task or outside an
+		 * interrupt that scans in the background. If the queue is
+		 * full, new events are dropped and counted in eventsDropped.
+		 */
+		#if defined(TL_ENABLE_EVENT_QUEUE)
+		bool getEvent(struct TLStateChangeEvent * event);
+		#endif
+
 		/* call backs: */
 		void (*buttonStateChangeCallback)(int ch,
 			enum TLStruct::ButtonState oldState,
@@ -379,15 +1025,98 @@ class TLSensors
 		 */
 		void (*sequenceMeasurementProgressCallback)(bool isStarted);
 
-	private:
+	protected:
+		#if !defined(TL_ENABLE_CONST_CONFIG)
+		struct TLStructConfig configBuf[N_SENSORS];
+		#endif
+
+		void setConfigDefault(uint8_t ch);
+
+		/*
+		 * step() and sampleChannels() are built from stepWith() and
+		 * sampleChannelsWith(), of which SAMPLER is a struct with
+		 * static functions preSample(s, ch), samplePosition(s, idx)
+		 * and postSample(s, ch). RuntimeSampler selects the sample
+		 * method, sample type and filter type from data[ch] at
+		 * runtime; TLSensorsStatic passes a sampler of which these are
+		 * fixed at compile time, so that they are inlined into the
+		 * scan loop.
+		 */
+		struct RuntimeSampler {
+			static void preSample(TLSensors * s, uint8_t ch)
+			{
+				int (*f)(struct TLStruct * d, uint8_t nSensors,
+					uint8_t ch);
+
+				f = TL_CONFIG(&(s->data[ch]),
+					sampleMethodPreSample);
+				if (f != NULL) {
+					f(s->data, s->nSensors, ch);
+				}
+			}
+
+			static void samplePosition(TLSensors * s, uint16_t idx)
+			{
+				s->samplePosition(idx);
+			}
+
+			static void postSample(TLSensors * s, uint8_t ch)
+			{
+				int (*f)(struct TLStruct * d, uint8_t nSensors,
+					uint8_t ch);
+
+				f = TL_CONFIG(&(s->data[ch]),
+					sampleMethodPostSample);
+				if (f != NULL) {
+					f(s->data, s->nSensors, ch);
+				}
+			}
+		};
+
+		template <class SAMPLER>
+		int8_t stepWith(uint16_t maxPositions);
+		template <class SAMPLER>
+		int8_t sampleChannelsWith(const TLBitset<N_SENSORS> & mask,
+			bool freezeSkipped);
+
+		enum ScanStage {
+			scanStageIdle = 0,
+			scanStagePreSample,
+			scanStageSample,
+			scanStagePostSample,
+			scanStageSummary
+		};
+
 		bool useCustomScanOrder;
+		const uint8_t * scanOrder;
 		bool anyButtonIsApproachedVar;
 		bool anyButtonIsPressedVar;
-		uint8_t pos;
-		int8_t addChannel(uint8_t ch);
-		void processFilterTypeAverage(uint8_t ch, int32_t sample);
+		enum ScanStage scanStage;
+		uint16_t pos; /* position in scanOrder or channel in scanStage */
+		unsigned long scanTime;
+		bool backgroundScan;
+		bool scanAllPositions;
+		bool freezeSkipped;
+		TLBitset<N_SENSORS> calibratingSensors;
+		TLBitset<N_SENSORS> releasedSensors;
+		TLBitset<N_SENSORS> approachedSensors;
+		TLBitset<N_SENSORS> pressedSensors;
+		#if defined(TL_ENABLE_EVENT_QUEUE)
+		struct TLStateChangeEvent eventBuf[TL_EVENT_QUEUE_LENGTH];
+		volatile uint8_t eventHead; /* written by producer only */
+		volatile uint8_t eventTail; /* written by consumer only */
+		void putEvent(uint8_t ch, enum TLStruct::ButtonState oldState,
+			enum TLStruct::ButtonState newState);
+		#endif
+		void processFilterTypeAverage(uint8_t ch, int32_t sample);
 		void processFilterTypeSlewrateLimiter(uint8_t ch, int32_t sample);
 		void processFilterTypeMedian(uint8_t ch, int32_t sample);
+		void processFilterTypeIIR(uint8_t ch, int32_t sample);
+		void processFilterTypeMedian3(uint8_t ch, int32_t sample);
+		void processFilterTypeTrimmedMean(uint8_t ch, int32_t sample);
+		void processRunningMedian(uint8_t ch);
+		void processAdaptiveMeasurements(uint8_t ch);
+		bool positionIsActive(uint16_t idx);
 		void addSample(uint8_t ch, int32_t sample);
 		bool isPressed(TLStruct * d);
 		bool isApproached(TLStruct * d);
@@ -397,6 +1126,7 @@ class TLSensors
 		void processStatePreCalibrating(uint8_t ch);
 		void processStateCalibrating(uint8_t ch);
 		void processStateNoisePowerMeasurement(uint8_t ch);
+		void processStateVerifying(uint8_t ch);
 		void processStateReleased(uint8_t ch);
 		void processStateReleasedToApproached(uint8_t ch);
 		void processStateApproached(uint8_t ch);
@@ -406,95 +1136,256 @@ class TLSensors
 		void processStateApproachedToReleased(uint8_t ch);
 		void processSample(uint8_t ch);
 		void resetButtonStateSummaries(uint8_t ch);
-		void initScanOrder(void);
-
-		/* These strings are for human readability */
-		const char * const buttonStateLabels[TLStruct::buttonStateMax +
-				1] = {
-			"PreCalibrating", "Calibrating",
-			"NoisePowerMeasurement", "Released",
-			"ReleasedToApproached", "Approached",
-			"ApproachedToPressed", "ApproachedToReleased",
-			"Pressed", "PressedToApproached", "Invalid"
-		};
+		void updateStateSets(uint8_t ch);
+		void updateButtonStateSummaries(void);
+		uint16_t snapshotConfigChecksum(void);
+		void samplePosition(uint16_t idx);
+		void sampleBackgroundPosition(uint16_t idx);
+		bool startBackgroundScan(uint16_t length);
+
+		/*
+		 * These strings are for human readability. Shared by all
+		 * instances.
+		 */
+		static const char * const buttonStateLabels[
+			TLStruct::buttonStateMax + 1];
+};
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+const char * const TLSensors<N_SENSORS,
+		N_MEASUREMENTS_PER_SENSOR>::buttonStateLabels[
+		TLStruct::buttonStateMax + 1] = {
+	"PreCalibrating", "Calibrating",
+	"NoisePowerMeasurement", "Verifying", "Released",
+	"ReleasedToApproached", "Approached",
+	"ApproachedToPressed", "ApproachedToReleased",
+	"Pressed", "PressedToApproached", "Invalid"
 };
 
 /* Actual implementation */
-#define TL_RELEASED_TO_APPROACHED_TIME_DEFAULT			10
-#define TL_APPROACHED_TO_RELEASED_TIME_DEFAULT			10
-#define TL_APPROACHED_TO_PRESSED_TIME_DEFAULT			10
-#define TL_PRESSED_TO_APPROACHED_TIME_DEFAULT			10
-#define TL_PRE_CALIBRATION_TIME_DEFAULT				100
-#define TL_CALIBRATION_TIME_DEFAULT				500
-#define TL_FILTER_COEFF_DEFAULT					16
-#define TL_APPROACHED_TIMEOUT_DEFAULT				300000
-#define TL_PRESSED_TIMEOUT_DEFAULT				TL_APPROACHED_TIMEOUT_DEFAULT
-#define TL_FORCE_CALIBRATION_WHEN_RELEASING_FROM_APPROACHED_DEFAULT	0
-#define TL_FORCE_CALIBRATION_WHEN_APPROACHING_FROM_RELEASED_DEFAULT	0
-#define TL_FORCE_CALIBRATION_WHEN_APPROACHING_FROM_PRESSED_DEFAULT	0
-#define TL_FORCE_CALIBRATION_WHEN_PRESSING_DEFAULT		0
-#define TL_USE_CUSTOM_SCAN_ORDER_DEFAULT			false
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setScanOrder(
+		const uint8_t * customScanOrder)
+{
+	if (customScanOrder != NULL) {
+		useCustomScanOrder = true;
+		scanOrder = customScanOrder;
+	} else {
+		useCustomScanOrder = false;
+		scanOrder = TLScanOrderTable<N_SENSORS,
+			N_MEASUREMENTS_PER_SENSOR>::table;
+	}
+}
 
-#define TL_ENABLE_TOUCH_STATE_MACHINE_DEFAULT			true
-#define TL_ENABLE_NOISE_POWER_MEASUREMENT_DEFAULT		false
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+inline uint8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::getScanOrder(
+		uint16_t idx)
+{
+	#if IS_AVR
+	if (!useCustomScanOrder) {
+		return TL_SCAN_ORDER_READ(scanOrder, idx);
+	}
+	#endif
 
-#define TL_DISABLE_UPDATE_IF_ANY_BUTTON_IS_APPROACHED_DEFAULT	false
-#define TL_DISABLE_UPDATE_IF_ANY_BUTTON_IS_PRESSED_DEFAULT	false
+	return scanOrder[idx];
+}
 
-#define TL_SAMPLE_METHOD_DEFAULT				(&TLSampleMethodCVD)
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+uint16_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::snapshotConfigChecksum(void)
+{
+	struct TLSnapshotConfig c;
+	uint16_t sum = 0;
+	uint8_t ch;
+	TLStruct * d;
+
+	for (ch = 0; ch < nSensors; ch++) {
+		d = &(data[ch]);
+
+		/* Function addresses change between builds; use an ID */
+		memset(&c, 0, sizeof(c));
+		if (TL_CONFIG(d, sampleMethodSample) ==
+				TLSampleMethodCVDSample) {
+			c.sampleMethod = TL_SNAPSHOT_SAMPLE_METHOD_CVD;
+			c.pin = TL_CONFIG(d, tlStructSampleMethod.CVD.pin);
+		} else if (TL_CONFIG(d, sampleMethodSample) ==
+				TLSampleMethodResistiveSample) {
+			c.sampleMethod = TL_SNAPSHOT_SAMPLE_METHOD_RESISTIVE;
+			c.pin = TL_CONFIG(d, tlStructSampleMethod.resistive.pin);
+		} else if (TL_CONFIG(d, sampleMethodSample) ==
+				TLSampleMethodTouchReadSample) {
+			c.sampleMethod = TL_SNAPSHOT_SAMPLE_METHOD_TOUCHREAD;
+			c.pin = TL_CONFIG(d, tlStructSampleMethod.touchRead.pin);
+		} else {
+			c.sampleMethod = TL_SNAPSHOT_SAMPLE_METHOD_CUSTOM;
+			c.pin = TL_CONFIG(d, tlStructSampleMethod.custom.pin);
+		}
+		c.referenceValue = TL_CONFIG(d, referenceValue);
+		c.scaleFactor = TL_CONFIG(d, scaleFactor);
+		c.releasedToApproachedThreshold =
+			TL_CONFIG(d, releasedToApproachedThreshold);
+		c.approachedToReleasedThreshold =
+			TL_CONFIG(d, approachedToReleasedThreshold);
+		c.approachedToPressedThreshold =
+			TL_CONFIG(d, approachedToPressedThreshold);
+		c.pressedToApproachedThreshold =
+			TL_CONFIG(d, pressedToApproachedThreshold);
+		c.sampleType = TL_CONFIG(d, sampleType);
+		c.direction = TL_CONFIG(d, direction);
+
+		sum = TLSnapshotChecksum((const uint8_t *) &c, sizeof(c), sum);
+	}
+
+	return sum;
+}
 
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
-int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::addChannel(uint8_t ch)
+int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::saveSnapshot(
+		struct TLStorage * storage)
 {
-	long r;
-	uint16_t n, pos, length;
-	int8_t err = -1;
+	struct TLSnapshotHeader h;
+	struct TLSnapshotSensor r;
+	uint16_t address, sum = 0;
+	uint8_t ch;
+	TLStruct * d;
 
-	length = ((uint16_t) nSensors) * ((uint16_t) nMeasurementsPerSensor);
-	
-	r = random(0, length);
+	static_assert(sizeof(r.baselineState) ==
+		sizeof(union TLStruct::TLStructBaselineMethod),
+		"baseline method state does not fit in snapshot");
 
-	for (n = 0; n < length; n++) {
-		pos = (n + r) % length;
-		if (scanOrder[pos] == 255) {
-			scanOrder[pos] = ch;
-			err = 0;
-			break;
+	if ((storage == NULL) || (storage->write == NULL)) {
+		return -1;
+	}
+
+	/* Header is written last, so an interrupted save is not valid */
+	address = sizeof(h);
+	for (ch = 0; ch < nSensors; ch++) {
+		d = &(data[ch]);
+
+		memset(&r, 0, sizeof(r));
+		r.avg = d->avg;
+		r.offsetValue = d->offsetValue;
+		r.noisePower = d->noisePower;
+		memcpy(&(r.baselineState), &(d->tlStructBaselineMethod),
+			sizeof(r.baselineState));
+		if (TL_CONFIG(d, sampleMethodSample) ==
+				TLSampleMethodCVDSample) {
+			r.isCVD = true;
+			r.nCharges = d->tlStructSampleMethodState.CVD.nCharges;
+		}
+		r.isCalibrated = (!d->disableSensor) &&
+			(d->buttonState >= TLStruct::buttonStateReleased);
+
+		sum = TLSnapshotChecksum((const uint8_t *) &r, sizeof(r), sum);
+		if (storage->write(storage, address, (const uint8_t *) &r,
+				sizeof(r)) != 0) {
+			return -1;
 		}
+		address += sizeof(r);
+	}
+
+	h.magic = TL_SNAPSHOT_MAGIC;
+	h.version = TL_SNAPSHOT_VERSION;
+	h.nSensors = nSensors;
+	h.nMeasurementsPerSensor = nMeasurementsPerSensor;
+	h.sizeOfSensor = sizeof(r);
+	h.checksum = sum;
+	h.configChecksum = snapshotConfigChecksum();
+	h.reserved[0] = 0;
+	h.reserved[1] = 0;
+	if (storage->write(storage, 0, (const uint8_t *) &h, sizeof(h)) != 0) {
+		return -1;
+	}
+
+	if ((storage->commit != NULL) && (storage->commit(storage) != 0)) {
+		return -1;
 	}
 
-	error = err;
-	return err;
+	return 0;
 }
 
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
-void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::initScanOrder(void)
+int TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::restoreSnapshot(
+		struct TLStorage * storage)
 {
-	uint16_t pos, length;
-	uint8_t n, k;
+	struct TLSnapshotHeader h;
+	struct TLSnapshotSensor r;
+	uint16_t address, sum = 0;
+	uint16_t filterCoeff;
+	uint8_t ch;
+	int nRestored = 0;
+	TLStruct * d;
 
-	length = ((uint16_t) nSensors) * ((uint16_t) nMeasurementsPerSensor);
+	if ((storage == NULL) || (storage->read == NULL)) {
+		return -1;
+	}
 
-	for (pos = 0; pos < length; pos++) {
-		scanOrder[pos] = 255;
+	if ((storage->read(storage, 0, (uint8_t *) &h, sizeof(h)) != 0) ||
+			(h.magic != TL_SNAPSHOT_MAGIC) ||
+			(h.version != TL_SNAPSHOT_VERSION) ||
+			(h.nSensors != nSensors) ||
+			(h.nMeasurementsPerSensor != nMeasurementsPerSensor) ||
+			(h.sizeOfSensor != sizeof(r)) ||
+			(h.configChecksum != snapshotConfigChecksum())) {
+		return -1;
 	}
-	
-	/*
-	 * Use a fixed seed so that scan order is pseudo random but always the
-	 * same.
-	 */
-	randomSeed(nMeasurementsPerSensor);
 
-	for (k = 0; k < nMeasurementsPerSensor; k++) {
-		for (n = 0; n < nSensors; n++) {
-			addChannel(n);
+	/* Verify checksum first so that nothing is restored if it fails */
+	address = sizeof(h);
+	for (ch = 0; ch < nSensors; ch++) {
+		if (storage->read(storage, address, (uint8_t *) &r,
+				sizeof(r)) != 0) {
+			return -1;
+		}
+		sum = TLSnapshotChecksum((const uint8_t *) &r, sizeof(r), sum);
+		address += sizeof(r);
+	}
+	if (sum != h.checksum) {
+		return -1;
+	}
+
+	address = sizeof(h);
+	for (ch = 0; ch < nSensors; ch++, address += sizeof(r)) {
+		d = &(data[ch]);
+
+		if ((storage->read(storage, address, (uint8_t *) &r,
+				sizeof(r)) != 0) || (!r.isCalibrated) ||
+				(d->disableSensor)) {
+			continue;
 		}
+
+		d->avg = r.avg;
+		if (!TL_CONFIG(d, setOffsetValueManually)) {
+			d->offsetValue = r.offsetValue;
+		}
+		d->noisePower = r.noisePower;
+		memcpy(&(d->tlStructBaselineMethod), &(r.baselineState),
+			sizeof(r.baselineState));
+		if (r.isCVD && (TL_CONFIG(d, sampleMethodSample) ==
+				TLSampleMethodCVDSample)) {
+			d->tlStructSampleMethodState.CVD.nCharges = r.nCharges;
+			d->tlStructSampleMethodState.CVD.nChargesNext = r.nCharges;
+		}
+
+		/* Baseline is settled; continue with the slowest update */
+		filterCoeff = TL_CONFIG(d, filterCoeff);
+		d->counter = (filterCoeff > 0) ? filterCoeff - 1 : 0;
+		d->noiseCounter = d->counter;
+		d->maxDelta = 0;
+		d->forcedCal = false;
+
+		setState(ch, TLStruct::buttonStateVerifying);
+		d->buttonStateLabel = buttonStateLabels[d->buttonState];
+		nRestored++;
 	}
+
+	return nRestored;
 }
 
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
 int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setDefaults(void)
 {
+	struct TLStructConfig * c;
+	TLStruct * d;
 	uint8_t n;
 	
 	error = 0;
@@ -508,65 +1399,83 @@ int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setDefaults(void)
 		this->anyButtonIsPressedVar = false;
 	}
 
-	if (error == 0) {
-		this->useCustomScanOrder = TL_USE_CUSTOM_SCAN_ORDER_DEFAULT;
-	
-		if (useCustomScanOrder == false) {
-			initScanOrder();
-		}
-	}
-
 	if (error == 0) {
 		buttonStateChangeCallback = NULL;
+		buttonMeasurementProgressCallback = NULL;
+		sequenceMeasurementProgressCallback = NULL;
 	}
 
 	if (error == 0) {
+		/* initialize() looks at the configuration of all sensors */
 		for (n = 0; n < nSensors; n++) {
+			setConfigDefault(n);
+		}
+		for (n = 0; n < nSensors; n++) {
+			d = &(data[n]);
 			initialize(n, TLSampleMethodCVD);
-			data[n].releasedToApproachedTime =
-				TL_RELEASED_TO_APPROACHED_TIME_DEFAULT;
-			data[n].approachedToReleasedTime =
-				TL_APPROACHED_TO_RELEASED_TIME_DEFAULT;
-			data[n].approachedToPressedTime =
-				TL_APPROACHED_TO_PRESSED_TIME_DEFAULT;
-			data[n].pressedToApproachedTime =
-				TL_PRESSED_TO_APPROACHED_TIME_DEFAULT;
-			data[n].preCalibrationTime =
-				TL_PRE_CALIBRATION_TIME_DEFAULT;
-			data[n].calibrationTime =
-				TL_CALIBRATION_TIME_DEFAULT;
-			data[n].filterCoeff =
-				TL_FILTER_COEFF_DEFAULT;
-			data[n].approachedTimeout =
-				TL_APPROACHED_TIMEOUT_DEFAULT;
-			data[n].pressedTimeout =
-				TL_PRESSED_TIMEOUT_DEFAULT;
-			data[n].forceCalibrationWhenReleasingFromApproached =
-				TL_FORCE_CALIBRATION_WHEN_RELEASING_FROM_APPROACHED_DEFAULT;
-			data[n].forceCalibrationWhenApproachingFromReleased =
-				TL_FORCE_CALIBRATION_WHEN_APPROACHING_FROM_RELEASED_DEFAULT;
-			data[n].forceCalibrationWhenApproachingFromPressed =
-				TL_FORCE_CALIBRATION_WHEN_APPROACHING_FROM_PRESSED_DEFAULT;
-			data[n].forceCalibrationWhenPressing =
-				TL_FORCE_CALIBRATION_WHEN_PRESSING_DEFAULT;
-			data[n].enableTouchStateMachine = 
-				TL_ENABLE_TOUCH_STATE_MACHINE_DEFAULT;
-			data[n].enableNoisePowerMeasurement =
-				TL_ENABLE_NOISE_POWER_MEASUREMENT_DEFAULT;
-			data[n].disableUpdateIfAnyButtonIsApproached =
-				TL_DISABLE_UPDATE_IF_ANY_BUTTON_IS_APPROACHED_DEFAULT;
-			data[n].disableUpdateIfAnyButtonIsPressed =
-				TL_DISABLE_UPDATE_IF_ANY_BUTTON_IS_PRESSED_DEFAULT;
-			data[n].stateIsBeingChanged = false;
-			data[n].sampleMethod = TL_SAMPLE_METHOD_DEFAULT;
-			if (!data[n].setOffsetValueManually) {
+			c = TLConfigWritable(d);
+			if (c != NULL) {
+				c->releasedToApproachedTime =
+					TL_RELEASED_TO_APPROACHED_TIME_DEFAULT;
+				c->approachedToReleasedTime =
+					TL_APPROACHED_TO_RELEASED_TIME_DEFAULT;
+				c->approachedToPressedTime =
+					TL_APPROACHED_TO_PRESSED_TIME_DEFAULT;
+				c->pressedToApproachedTime =
+					TL_PRESSED_TO_APPROACHED_TIME_DEFAULT;
+				c->preCalibrationTime =
+					TL_PRE_CALIBRATION_TIME_DEFAULT;
+				c->calibrationTime =
+					TL_CALIBRATION_TIME_DEFAULT;
+				c->filterCoeff =
+					TL_FILTER_COEFF_DEFAULT;
+				c->filterIIRShift =
+					TL_FILTER_IIR_SHIFT_DEFAULT;
+				c->filterTrim =
+					TL_FILTER_TRIM_DEFAULT;
+				c->runningMedianLength =
+					TL_RUNNING_MEDIAN_LENGTH_DEFAULT;
+				c->approachedTimeout =
+					TL_APPROACHED_TIMEOUT_DEFAULT;
+				c->pressedTimeout =
+					TL_PRESSED_TIMEOUT_DEFAULT;
+				c->enableTouchStateMachine = 
+					TL_ENABLE_TOUCH_STATE_MACHINE_DEFAULT;
+				c->enableNoisePowerMeasurement =
+					TL_ENABLE_NOISE_POWER_MEASUREMENT_DEFAULT;
+				c->enableAdaptiveMeasurements =
+					TL_ENABLE_ADAPTIVE_MEASUREMENTS_DEFAULT;
+				c->minMeasurementsPerSensor =
+					TL_MIN_MEASUREMENTS_PER_SENSOR_DEFAULT;
+				c->disableUpdateIfAnyButtonIsApproached =
+					TL_DISABLE_UPDATE_IF_ANY_BUTTON_IS_APPROACHED_DEFAULT;
+				c->disableUpdateIfAnyButtonIsPressed =
+					TL_DISABLE_UPDATE_IF_ANY_BUTTON_IS_PRESSED_DEFAULT;
+				c->sampleMethod = TL_SAMPLE_METHOD_DEFAULT;
+				c->baselineMethod = TL_BASELINE_METHOD_DEFAULT;
+			}
+			forceCalibrationWhenReleasingFromApproached[n].fromMask(
+				TL_FORCE_CALIBRATION_WHEN_RELEASING_FROM_APPROACHED_DEFAULT,
+				false);
+			forceCalibrationWhenApproachingFromReleased[n].fromMask(
+				TL_FORCE_CALIBRATION_WHEN_APPROACHING_FROM_RELEASED_DEFAULT,
+				false);
+			forceCalibrationWhenApproachingFromPressed[n].fromMask(
+				TL_FORCE_CALIBRATION_WHEN_APPROACHING_FROM_PRESSED_DEFAULT,
+				false);
+			forceCalibrationWhenPressing[n].fromMask(
+				TL_FORCE_CALIBRATION_WHEN_PRESSING_DEFAULT, false);
+			d->stateIsBeingChanged = false;
+			if (!TL_CONFIG(d, setOffsetValueManually)) {
 				/*
 				 * Set offsetValue to 0; will be updated
 				 * after calibration.
 				 */
-				data[n].offsetValue = 0;
+				d->offsetValue = 0;
 			}
-			data[n].filterParams.slewrateLimiter.idx = 0;
+			d->filterParams.slewrateLimiter.idx = 0;
+			d->filterParams.iir.primed = false;
+			d->filterTypePrev = TL_CONFIG(d, filterType);
 		}
 		#if defined(TL_ENABLE_LARGE_FILTER_BUF)
 		memset(filterBuf, 0, sizeof(int32_t) * N_SENSORS *
@@ -585,7 +1494,13 @@ TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::~TLSensors(void)
 	/* Nothing to destroy */
 }
 
-#warning overload constructor with uint8_t customScanOrder[]
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::TLSensors(
+		const uint8_t * customScanOrder) : TLSensors()
+{
+	setScanOrder(customScanOrder);
+}
+
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
 TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::TLSensors(void)
 {
@@ -594,6 +1509,17 @@ TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::TLSensors(void)
 	
 	error = 0;
 	pos = 0;
+	scanStage = scanStageIdle;
+	scanTime = 0;
+	backgroundScan = false;
+	scanAllPositions = true;
+	freezeSkipped = true;
+	#if defined(TL_ENABLE_EVENT_QUEUE)
+	eventHead = 0;
+	eventTail = 0;
+	eventsDropped = 0;
+	eventsMaxQueued = 0;
+	#endif
 
 	if (N_SENSORS < 1) {
 		error = -1;
@@ -608,7 +1534,7 @@ TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::TLSensors(void)
 	}
 
 	if (error == 0) {
-		initScanOrder();
+		setScanOrder(NULL);
 	}
 
 	if (error == 0) {
@@ -620,11 +1546,18 @@ TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::TLSensors(void)
 
 		for (n = 0; n < nSensors; n++) {
 			resetButtonStateSummaries(n);
-			setState(n, TLStruct::buttonStatePreCalibrating);
+			/*
+			 * Not setState(): the previous state is undefined for
+			 * objects on the stack or heap, and would be reported
+			 * as a state change (and queued as an event)
+			 */
+			data[n].buttonState =
+				TLStruct::buttonStatePreCalibrating;
 			data[n].buttonStateLabel =
 				this->buttonStateLabels[data[n].buttonState];
 			data[n].counter = 0;
 			data[n].noiseCounter = 0;
+			data[n].runningMedianN = 0;
 			data[n].forcedCal = false;
 			data[n].raw = 0;
 			data[n].value = 0;
@@ -634,8 +1567,20 @@ TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::TLSensors(void)
 			data[n].maxDelta = 0;
 			data[n].maxDelta = 0;
 			data[n].stateChangedAtTime = now;
-			data[n].lastSampledAtTime = 0;
+			data[n].lastSampledAtTime = now;
 			data[n].nMeasurementsPerSensor = nMeasurementsPerSensor;
+			data[n].adaptiveHoldCounter = 0;
+			data[n].scanActive = true;
+			data[n].disableSensor = false;
+			data[n].disableSensorPrev = false;
+		}
+
+		calibratingSensors.clearAll();
+		releasedSensors.clearAll();
+		approachedSensors.clearAll();
+		pressedSensors.clearAll();
+		for (n = 0; n < nSensors; n++) {
+			updateStateSets(n);
 		}
 	}
 }
@@ -659,8 +1604,7 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processFilterTypeSlewrateL
 		buf[0] = data[ch].raw;
 		buf[1] = filterBuf[ch][0];
 		buf[2] = sample;
-		combSort(buf, 3);
-		data[ch].raw = buf[1];
+		data[ch].raw = TLMedian<3>::median(buf);
 		break;
 	default:
 		if (sample > data[ch].raw) {
@@ -685,27 +1629,239 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processFilterTypeMedian(ui
 	if (++data[ch].filterParams.median.idx >= N_MEASUREMENTS_PER_SENSOR) {
 		data[ch].filterParams.median.idx = 0;
 
-		combSort(filterBuf[ch], N_MEASUREMENTS_PER_SENSOR);
+		data[ch].raw = TLMedian<N_MEASUREMENTS_PER_SENSOR>::median(
+			filterBuf[ch]);
+	}
+	#else
+	/* Error! */
+	#endif
+}
 
-		#if (N_MEASUREMENTS_PER_SENSOR & 0x01)
-		data[ch].raw = filterBuf[ch][(N_MEASUREMENTS_PER_SENSOR - 1)
-			/ 2];
-		#else
-		data[ch].raw = (filterBuf[ch][N_MEASUREMENTS_PER_SENSOR / 2]
-				+ filterBuf[ch][(N_MEASUREMENTS_PER_SENSOR +
-					1) / 2]) >> 1;
-		#endif
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processFilterTypeIIR(uint8_t ch, int32_t sample)
+{
+	struct TLStruct::FilterParamsIIR * f = &(data[ch].filterParams.iir);
+	uint8_t shift = TL_CONFIG(&(data[ch]), filterIIRShift);
+	int32_t m = data[ch].nMeasurementsPerSensor;
+
+	if (shift > TL_FILTER_IIR_SHIFT_MAX) {
+		shift = TL_FILTER_IIR_SHIFT_MAX;
+	}
+
+	if (f->primed) {
+		f->state += sample - (f->state >> shift);
+	} else {
+		/* Start at first sample instead of slowly rising from 0 */
+		f->state = sample * (((int32_t) 1) << shift);
+		f->primed = true;
+	}
+
+	/*
+	 * Scale raw to the sum of nMeasurementsPerSensor samples, as with
+	 * filterTypeAverage, so that sample methods can use the same scale
+	 * and part of the fractional bits of the state are kept. Integer and
+	 * fractional part are multiplied separately to avoid overflow.
+	 */
+	data[ch].raw = (f->state >> shift) * m +
+		(((f->state & ((((int32_t) 1) << shift) - 1)) * m) >> shift);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processFilterTypeMedian3(uint8_t ch, int32_t sample)
+{
+	struct TLStruct::FilterParamsMedian3 * f =
+		&(data[ch].filterParams.median3);
+	uint8_t m = data[ch].nMeasurementsPerSensor;
+	int32_t buf[3], med;
+
+	if (m < 3) {
+		data[ch].raw += sample;
+		return;
+	}
+
+	/*
+	 * Measurement idx - 1 is replaced by the median of measurements
+	 * idx - 2, idx - 1 and idx. The first and last measurement have only
+	 * one neighbour; they are replaced by the median of the first and
+	 * last 3 measurements. Like filterTypeAverage, raw is the sum of
+	 * nMeasurementsPerSensor values.
+	 */
+	if (f->idx >= 2) {
+		buf[0] = f->prev[0];
+		buf[1] = f->prev[1];
+		buf[2] = sample;
+		med = TLMedian<3>::median(buf);
+
+		data[ch].raw += med;
+		if (f->idx == 2) {
+			data[ch].raw += med;
+		}
+		if (f->idx == m - 1) {
+			data[ch].raw += med;
+		}
+	}
+
+	f->prev[0] = f->prev[1];
+	f->prev[1] = sample;
+	f->idx++;
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processFilterTypeTrimmedMean(uint8_t ch, int32_t sample)
+{
+	#if defined(TL_ENABLE_TRIMMED_MEAN_FILTER)
+	uint8_t idx = data[ch].filterParams.trimmedMean.idx++;
+	uint8_t m = data[ch].nMeasurementsPerSensor;
+	uint8_t k = TL_CONFIG(&(data[ch]), filterTrim);
+	int32_t * high = trimBufHigh[ch];
+	int32_t * low = trimBufLow[ch];
+	uint8_t n;
+
+	/* At least one measurement must remain */
+	if (k > TL_TRIMMED_MEAN_TRIM_MAX) {
+		k = TL_TRIMMED_MEAN_TRIM_MAX;
+	}
+	if (k > (m - 1) / 2) {
+		k = (m - 1) / 2;
+	}
+
+	data[ch].raw += sample;
+
+	/* Insert sample in the k + 1 highest and k + 1 lowest measurements */
+	n = (idx < k) ? idx : k;
+	if ((idx <= k) || (sample > high[k])) {
+		while ((n > 0) && (high[n - 1] < sample)) {
+			high[n] = high[n - 1];
+			n--;
+		}
+		high[n] = sample;
+	}
+	n = (idx < k) ? idx : k;
+	if ((idx <= k) || (sample < low[k])) {
+		while ((n > 0) && (low[n - 1] > sample)) {
+			low[n] = low[n - 1];
+			n--;
+		}
+		low[n] = sample;
+	}
+
+	/* Replace the k highest and k lowest by high[k] and low[k] */
+	if (idx == m - 1) {
+		for (n = 0; n < k; n++) {
+			data[ch].raw += (high[k] - high[n]) + (low[k] - low[n]);
+		}
 	}
 	#else
 	/* Error! */
 	#endif
 }
 
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processRunningMedian(uint8_t ch)
+{
+	#if defined(TL_ENABLE_RUNNING_MEDIAN)
+	uint8_t length = TL_CONFIG(&(data[ch]), runningMedianLength);
+
+	if (length <= 1) {
+		return;
+	}
+	if (length > TL_RUNNING_MEDIAN_LENGTH_MAX) {
+		length = TL_RUNNING_MEDIAN_LENGTH_MAX;
+	}
+
+	data[ch].value = TLRunningMedianAdd(runningMedianBuf[ch],
+		runningMedianAge[ch], &(data[ch].runningMedianN), length,
+		data[ch].value);
+	#endif
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::positionIsActive(uint16_t idx)
+{
+	TLStruct * d;
+
+	d = &(data[getScanOrder(idx)]);
+
+	if (!d->scanActive) {
+		return false;
+	}
+
+	/*
+	 * Measure nMeasurementsPerSensor of the nMeasurementsPerSensor
+	 * positions of this sensor, spread evenly (Bresenham).
+	 */
+	d->measurementAcc += d->nMeasurementsPerSensor;
+	if (d->measurementAcc < nMeasurementsPerSensor) {
+		return false;
+	}
+	d->measurementAcc -= nMeasurementsPerSensor;
+
+	return true;
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processAdaptiveMeasurements(uint8_t ch)
+{
+	TLStruct * d;
+	uint32_t thr;
+	uint64_t thr2, np;
+	uint8_t m;
+
+	d = &(data[ch]);
+	m = d->nMeasurementsPerSensor;
+
+	if (!TL_CONFIG(d, enableAdaptiveMeasurements) ||
+			!TL_CONFIG(d, enableNoisePowerMeasurement) ||
+			(TL_CONFIG(d, filterType) ==
+			TLStruct::filterTypeMedian) ||
+			(d->buttonState != TLStruct::buttonStateReleased)) {
+		d->nMeasurementsPerSensor = nMeasurementsPerSensor;
+		d->adaptiveHoldCounter = 0;
+		return;
+	}
+
+	/* Wait until noisePower has settled after the last change */
+	if (d->adaptiveHoldCounter < TL_CONFIG(d, filterCoeff)) {
+		d->adaptiveHoldCounter++;
+		return;
+	}
+
+	/*
+	 * Target is the noise power at which noise level * margin equals the
+	 * threshold: noisePower * margin^2 == thr^2. Compared without
+	 * dividing, so that small thresholds (like the CVD default) work.
+	 */
+	thr = (TL_CONFIG(d, approachedToReleasedThreshold) > 0) ?
+		TL_CONFIG(d, approachedToReleasedThreshold) : 0;
+	thr2 = ((uint64_t) thr) * thr;
+	np = ((uint64_t) d->noisePower) *
+		(TL_ADAPTIVE_MEASUREMENTS_NOISE_MARGIN *
+		TL_ADAPTIVE_MEASUREMENTS_NOISE_MARGIN);
+
+	/*
+	 * Halving the number of measurements doubles noise power; only do so
+	 * if it stays below half the target to avoid toggling.
+	 */
+	if (np > thr2) {
+		m = ((m << 1) > nMeasurementsPerSensor) ?
+			nMeasurementsPerSensor : (m << 1);
+	} else if ((np << 2) < thr2) {
+		m = ((m >> 1) < TL_CONFIG(d, minMeasurementsPerSensor)) ?
+			TL_CONFIG(d, minMeasurementsPerSensor) : (m >> 1);
+		m = (m < 1) ? 1 : m;
+		m = (m > nMeasurementsPerSensor) ? nMeasurementsPerSensor : m;
+	}
+
+	if (m != d->nMeasurementsPerSensor) {
+		d->nMeasurementsPerSensor = m;
+		d->adaptiveHoldCounter = 0;
+	}
+}
 
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
 void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::addSample(uint8_t ch, int32_t sample)
 {
-	switch (data[ch].filterType) {
+	switch (TL_CONFIG(&(data[ch]), filterType)) {
 	case TLStruct::filterTypeAverage:
 		processFilterTypeAverage(ch, sample);
 		break;
@@ -715,6 +1871,15 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::addSample(uint8_t ch, int3
 	case TLStruct::filterTypeMedian:
 		processFilterTypeMedian(ch, sample);
 		break;
+	case TLStruct::filterTypeIIR:
+		processFilterTypeIIR(ch, sample);
+		break;
+	case TLStruct::filterTypeMedian3:
+		processFilterTypeMedian3(ch, sample);
+		break;
+	case TLStruct::filterTypeTrimmedMean:
+		processFilterTypeTrimmedMean(ch, sample);
+		break;
 	default:
 		/* Error! */
 		break;
@@ -724,65 +1889,53 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::addSample(uint8_t ch, int3
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
 bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::anyButtonIsCalibrating(void)
 {
-	bool ret = false;
-	uint8_t n;
-
-	for (n = 0; n < N_SENSORS; n++) {
-		if (isCalibrating(&(data[n]))) {
-			ret = true;
-			break;
-		}
-	}
-
-	return ret;
+	return calibratingSensors.any();
 }
 
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
 bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::anyButtonIsReleased(void)
 {
-	bool ret = false;
-	uint8_t n;
-
-	for (n = 0; n < N_SENSORS; n++) {
-		if (isReleased(&(data[n]))) {
-			ret = true;
-			break;
-		}
-	}
-
-	return ret;
+	return releasedSensors.any();
 }
 
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
 bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::anyButtonIsApproached(void)
 {
-	bool ret = false;
-	uint8_t n;
+	return approachedSensors.any();
+}
 
-	for (n = 0; n < N_SENSORS; n++) {
-		if (isApproached(&(data[n]))) {
-			ret = true;
-			break;
-		}
-	}
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::anyButtonIsPressed(void)
+{
+	return pressedSensors.any();
+}
 
-	return ret;
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+const TLBitset<N_SENSORS> & TLSensors<N_SENSORS,
+		N_MEASUREMENTS_PER_SENSOR>::getCalibratingSensors(void)
+{
+	return calibratingSensors;
 }
 
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
-bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::anyButtonIsPressed(void)
+const TLBitset<N_SENSORS> & TLSensors<N_SENSORS,
+		N_MEASUREMENTS_PER_SENSOR>::getReleasedSensors(void)
 {
-	bool ret = false;
-	uint8_t n;
+	return releasedSensors;
+}
 
-	for (n = 0; n < N_SENSORS; n++) {
-		if (isPressed(&(data[n]))) {
-			ret = true;
-			break;
-		}
-	}
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+const TLBitset<N_SENSORS> & TLSensors<N_SENSORS,
+		N_MEASUREMENTS_PER_SENSOR>::getApproachedSensors(void)
+{
+	return approachedSensors;
+}
 
-	return ret;
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+const TLBitset<N_SENSORS> & TLSensors<N_SENSORS,
+		N_MEASUREMENTS_PER_SENSOR>::getPressedSensors(void)
+{
+	return pressedSensors;
 }
 
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
@@ -799,6 +1952,9 @@ int TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::getSensorWithLargestDelta(v
 	maxDelta = -1;
 	max_n = 0;
 	for (n = 0; n < N_SENSORS; n++) {
+		if (data[n].disableSensor) {
+			continue;
+		}
 		tmp = getDelta(n);
 		if (tmp > maxDelta) {
 			maxDelta = tmp;
@@ -814,7 +1970,7 @@ bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::isCalibrating(TLStruct * d
 {
 	bool ret = false;
 
-	if (d->buttonState <= TLStruct::buttonStateNoisePowerMeasurement) {
+	if (d->buttonState <= TLStruct::buttonStateVerifying) {
 		ret = true;
 	}
 
@@ -832,7 +1988,7 @@ bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::isReleased(TLStruct * d)
 {
 	bool ret = false;
 
-	if (d->delta <= d->approachedToReleasedThreshold) {
+	if (d->delta <= TL_CONFIG(d, approachedToReleasedThreshold)) {
 		ret = true;
 	}
 
@@ -850,7 +2006,7 @@ bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::isApproached(TLStruct * d)
 {
 	bool ret = false;
 
-	if (d->delta >= d->releasedToApproachedThreshold) {
+	if (d->delta >= TL_CONFIG(d, releasedToApproachedThreshold)) {
 		ret = true;
 	}
 
@@ -868,7 +2024,7 @@ bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::isPressed(TLStruct * d)
 {
 	bool ret = false;
 
-	if (d->delta >= d->approachedToPressedThreshold) {
+	if (d->delta >= TL_CONFIG(d, approachedToPressedThreshold)) {
 		ret = true;
 	}
 
@@ -884,85 +2040,56 @@ bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::isPressed(int n)
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
 void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::updateAvg(uint8_t ch)
 {
-	uint32_t s;
+	bool updateNoisePower;
 	TLStruct * d;
 
 	d = &(data[ch]);
 
 	if (!d->forcedCal && (d->buttonState >=
 			TLStruct::buttonStateReleased) && 
-			(d->disableUpdateIfAnyButtonIsApproached &&
+			(TL_CONFIG(d, disableUpdateIfAnyButtonIsApproached) &&
 			this->anyButtonIsApproachedVar)) {
 		return;
 	}
 	if (!d->forcedCal && (d->buttonState >=
 			TLStruct::buttonStateReleased) &&
-			(d->disableUpdateIfAnyButtonIsPressed &&
+			(TL_CONFIG(d, disableUpdateIfAnyButtonIsPressed) &&
 			this->anyButtonIsPressedVar)) {
 		return;
 	}
 
-	d->avg = (d->counter * d->avg + d->value) / (d->counter + 1);
+	/* Only perform noise measurement when not calibrating any more */
+	updateNoisePower = (TL_CONFIG(d, enableNoisePowerMeasurement)) &&
+		(d->buttonState > TLStruct::buttonStateCalibrating);
 
-	/*Serial.print("ch: ");
-	Serial.print(ch);
-	Serial.print("; state: ");
-	Serial.print(d->buttonState);
-	Serial.print("; counter: ");
-	Serial.print(d->counter);
-	Serial.print("; value: ");
-	Serial.print(d->value);
-	Serial.print("; avg: ");
-	Serial.print(d->avg);*/
+	TL_CONFIG(d, baselineMethod)(d, updateNoisePower);
 
-	/* Only perform noise measurement when not calibrating any more */
-	if ((d->enableNoisePowerMeasurement) && (d->buttonState >
-			TLStruct::buttonStateCalibrating)) {
-		if (d->delta <= 0xFFFF) {
-			s = d->delta * d->delta;
-		} else {
-			s = 0xFFFFFFFF;
-		}
-		d->noisePower = (d->noiseCounter * d->noisePower + s) / 
-			(d->noiseCounter + 1);
-		
-		/*Serial.print("; noiseCounter: ");
-		Serial.print(d->noiseCounter);
-		Serial.print("; delta: ");
-		Serial.print(d->delta);
-		Serial.print(", s: ");
-		Serial.print(s);
-		Serial.print("; noisePower: ");
-		Serial.print(d->noisePower);*/
-	
-		if (d->noiseCounter < (uint32_t) (d->filterCoeff - 1)) {
-			d->noiseCounter++;
-		}
+	if ((updateNoisePower) && (d->noiseCounter <
+			(uint32_t) (TL_CONFIG(d, filterCoeff) - 1))) {
+		d->noiseCounter++;
 	}
-	//Serial.println("");
 
-	if (d->counter < (uint32_t) (d->filterCoeff - 1)) {
+	if (d->counter < (uint32_t) (TL_CONFIG(d, filterCoeff) - 1)) {
 		d->counter++;
 	}
 }
 
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
 bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setForceCalibratingStates(
-		int ch, uint32_t mask, enum TLStruct::ButtonState * newState)
+		int ch, const TLBitset<N_SENSORS> & mask,
+		enum TLStruct::ButtonState * newState)
 {
 	int n;
 	bool chStateChanged = false;
 
-	for (n = 0; n < N_SENSORS; n++) {
-		if (mask & (1 << n)) {
-			if (n == ch) {
-				chStateChanged = true;
-				*newState = TLStruct::buttonStatePreCalibrating;
-			} else {
-				setState(n, TLStruct::buttonStatePreCalibrating);
-			}
-			data[n].forcedCal = true;
+	for (n = mask.first(); (n >= 0) && (n < nSensors); n = mask.next(n)) {
+		if (n == ch) {
+			chStateChanged = true;
+			*newState = TLStruct::buttonStatePreCalibrating;
+		} else {
+			setState(n, TLStruct::buttonStatePreCalibrating);
 		}
+		data[n].forcedCal = true;
 	}
 
 	return chStateChanged;
@@ -1065,7 +2192,7 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setState(int ch,
 		enum TLStruct::ButtonState newState)
 {
 	bool setStateChangedAtTime = true;
-	uint32_t mask = 0;
+	const TLBitset<N_SENSORS> * mask = NULL;
 	enum TLStruct::ButtonState oldState;
 	TLStruct * d;
 
@@ -1097,6 +2224,10 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setState(int ch,
 		d->stateIsBeingChanged = true;
 		switch(newState) {
 		case TLStruct::buttonStatePreCalibrating:
+			if (TL_CONFIG(d, filterType) == TLStruct::filterTypeIIR) {
+				/* Restart filter at next sample */
+				d->filterParams.iir.primed = false;
+			}
 			break;
 		case TLStruct::buttonStateCalibrating:
 			d->counter = 0;
@@ -1106,7 +2237,7 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setState(int ch,
 			d->noisePower = 0;
 			d->forcedCal = false;
 	
-			if (!d->setOffsetValueManually) {
+			if (!TL_CONFIG(d, setOffsetValueManually)) {
 				/*
 				 * Set offsetValue to 0; will be updated
 				 * after calibration.
@@ -1116,10 +2247,12 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setState(int ch,
 			break;
 		case TLStruct::buttonStateNoisePowerMeasurement:
 			break;
+		case TLStruct::buttonStateVerifying:
+			break;
 		case TLStruct::buttonStateReleased:
 			if (d->buttonState == 
 					TLStruct::buttonStateApproachedToReleased) {
-				mask = d->forceCalibrationWhenReleasingFromApproached;
+				mask = &(forceCalibrationWhenReleasingFromApproached[ch]);
 			}
 			break;
 		case TLStruct::buttonStateReleasedToApproached:
@@ -1127,11 +2260,11 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setState(int ch,
 		case TLStruct::buttonStateApproached:
 			if (d->buttonState ==
 					TLStruct::buttonStateReleasedToApproached) {
-				mask = d->forceCalibrationWhenApproachingFromReleased;
+				mask = &(forceCalibrationWhenApproachingFromReleased[ch]);
 			}
 			if (d->buttonState ==
 					TLStruct::buttonStatePressedToApproached) {
-				mask = d->forceCalibrationWhenApproachingFromPressed;
+				mask = &(forceCalibrationWhenApproachingFromPressed[ch]);
 			}
 			break;
 		case TLStruct::buttonStateApproachedToPressed:
@@ -1139,7 +2272,7 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setState(int ch,
 		case TLStruct::buttonStateApproachedToReleased:
 			break;
 		case TLStruct::buttonStatePressed:
-			mask = d->forceCalibrationWhenPressing;
+			mask = &(forceCalibrationWhenPressing[ch]);
 			break;
 		case TLStruct::buttonStatePressedToApproached:
 			break;
@@ -1148,9 +2281,9 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setState(int ch,
 			newState = TLStruct::buttonStatePreCalibrating;
 		}
 
-		if (mask) {
+		if ((mask != NULL) && mask->any()) {
 			setStateChangedAtTime |= setForceCalibratingStates(ch,
-				mask, &newState);
+				*mask, &newState);
 		}
 
 		if (setStateChangedAtTime) {
@@ -1159,6 +2292,13 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setState(int ch,
 
 		oldState = d->buttonState;
 		d->buttonState = newState; 
+		updateStateSets(ch);
+
+		#if defined(TL_ENABLE_EVENT_QUEUE)
+		if (checkForMajorChange(oldState, newState)) {
+			putEvent(ch, oldState, newState);
+		}
+		#endif
 
 		if (checkForMajorChange(oldState, newState) &&
 				(buttonStateChangeCallback != NULL)) {
@@ -1168,20 +2308,90 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setState(int ch,
 	}
 }
 
+#if defined(TL_ENABLE_EVENT_QUEUE)
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::putEvent(uint8_t ch,
+		enum TLStruct::ButtonState oldState,
+		enum TLStruct::ButtonState newState)
+{
+	struct TLStateChangeEvent * e;
+	uint8_t head, n;
+
+	/* Indices run freely; their difference is the number of events */
+	head = eventHead;
+	n = (uint8_t) (head - eventTail);
+	if (n >= TL_EVENT_QUEUE_LENGTH) {
+		eventsDropped = eventsDropped + 1;
+		return;
+	}
+
+	e = &(eventBuf[head & (TL_EVENT_QUEUE_LENGTH - 1)]);
+	e->ch = ch;
+	e->oldState = oldState;
+	e->newState = newState;
+	e->time = data[ch].lastSampledAtTime;
+	e->delta = data[ch].delta;
+
+	/* Event must be complete before it is published */
+	TL_MEMORY_BARRIER();
+	eventHead = head + 1;
+
+	if (n + 1 > eventsMaxQueued) {
+		eventsMaxQueued = n + 1;
+	}
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::getEvent(
+		struct TLStateChangeEvent * event)
+{
+	uint8_t tail;
+
+	tail = eventTail;
+	if (tail == eventHead) {
+		return false;
+	}
+
+	/* Read event only after it has been published */
+	TL_MEMORY_BARRIER();
+	*event = eventBuf[tail & (TL_EVENT_QUEUE_LENGTH - 1)];
+
+	/* Event must be read before its slot is released */
+	TL_MEMORY_BARRIER();
+	eventTail = tail + 1;
+
+	return true;
+}
+#endif
+
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
 int TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::initialize(
 		uint8_t ch, int (*sampleMethod)(struct TLStruct * d,
 		uint8_t nSensors, uint8_t ch))
 {
+	struct TLStructConfig * c;
 	TLStruct * d;
 	int ret = 0;
 
 	d = &(data[ch]);
-
-	if (sampleMethod != NULL) {
-		d->sampleMethod = sampleMethod;
-		ret = d->sampleMethod(data, nSensors, ch);
+	c = TLConfigWritable(d);
+
+	if ((sampleMethod != NULL) && (c == NULL) &&
+			(sampleMethod != TL_CONFIG(d, sampleMethod))) {
+		/* Sample method of a const configuration can't be changed */
+		ret = -1;
+	} else if (sampleMethod != NULL) {
+		if (c != NULL) {
+			c->sampleMethod = sampleMethod;
+		}
+		ret = sampleMethod(data, nSensors, ch);
 		setState(ch, TLStruct::buttonStatePreCalibrating);
+
+		/* Sensors that use CVD may need another reference now */
+		TLSampleMethodCVDInvalidateReferences(data, nSensors);
+
+		TLFastPinInit(&(d->waterRejectFastPin),
+			TL_CONFIG(d, waterRejectPin));
 	}
 	if (ret) {
 		error = -1;
@@ -1190,6 +2400,79 @@ int TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::initialize(
 	return ret;
 }
 
+#if !defined(TL_ENABLE_CONST_CONFIG)
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+inline struct TLStructConfig & TLSensors<N_SENSORS,
+		N_MEASUREMENTS_PER_SENSOR>::config(uint8_t ch)
+{
+	return configBuf[ch];
+}
+#endif
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setConfigDefault(
+		uint8_t ch)
+{
+	#if defined(TL_ENABLE_CONST_CONFIG)
+	data[ch].config = &(TLConfigDefaultTable<N_SENSORS>::table[ch]);
+	#if IS_AVR
+	data[ch].configStorage = TLStruct::configStorageFlash;
+	#else
+	data[ch].configStorage = TLStruct::configStorageConst;
+	#endif
+	#else
+	data[ch].config = &(configBuf[ch]);
+	data[ch].configStorage = TLStruct::configStorageRam;
+	#endif
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+int TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setConfig(uint8_t ch,
+		const struct TLStructConfig * config, bool inFlash)
+{
+	TLStruct * d;
+
+	if (ch >= nSensors) {
+		return -1;
+	}
+
+	d = &(data[ch]);
+
+	if (config == NULL) {
+		setConfigDefault(ch);
+	} else {
+		d->config = config;
+		d->configStorage = inFlash ? TLStruct::configStorageFlash :
+			TLStruct::configStorageConst;
+	}
+
+	/* Runtime state follows the new configuration */
+	if (TL_CONFIG(d, sampleMethod) == TLSampleMethodCVD) {
+		TLSampleMethodCVDResetState(d);
+	}
+	TLSampleMethodCVDInvalidateReferences(data, nSensors);
+	TLFastPinInit(&(d->waterRejectFastPin), TL_CONFIG(d, waterRejectPin));
+	if (!TL_CONFIG(d, setOffsetValueManually)) {
+		d->offsetValue = 0;
+	}
+	setState(ch, TLStruct::buttonStatePreCalibrating);
+
+	return 0;
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+int TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::setConfigTable(
+		const struct TLStructConfig * table, bool inFlash)
+{
+	uint8_t ch;
+
+	for (ch = 0; ch < nSensors; ch++) {
+		setConfig(ch, (table != NULL) ? &(table[ch]) : NULL, inFlash);
+	}
+
+	return 0;
+}
+
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
 void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processStatePreCalibrating(uint8_t ch)
 {
@@ -1197,7 +2480,8 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processStatePreCalibrating
 
 	d = &(data[ch]);
 
-	if (d->lastSampledAtTime - d->stateChangedAtTime >= d->preCalibrationTime) {
+	if (d->lastSampledAtTime - d->stateChangedAtTime >=
+			TL_CONFIG(d, preCalibrationTime)) {
 		setState(ch, TLStruct::buttonStateCalibrating);
 	}
 }
@@ -1211,14 +2495,15 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processStateCalibrating(ui
 	d = &(data[ch]);
 
 	t = d->lastSampledAtTime - d->stateChangedAtTime;
-	t_max = d->calibrationTime;
+	t_max = TL_CONFIG(d, calibrationTime);
 
-	if ((d->counter < (uint32_t) (d->filterCoeff - 1)) || (t < t_max)) {
+	if ((d->counter < (uint32_t) (TL_CONFIG(d, filterCoeff) - 1)) ||
+			(t < t_max)) {
 		updateAvg(ch);
 	} else {
 		setState(ch, TLStruct::buttonStateNoisePowerMeasurement);
 	
-		if (!d->setOffsetValueManually) {
+		if (!TL_CONFIG(d, setOffsetValueManually)) {
 			d->offsetValue = d->avg;
 		}
 	}
@@ -1233,15 +2518,34 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processStateNoisePowerMeas
 	d = &(data[ch]);
 
 	t = d->lastSampledAtTime - d->stateChangedAtTime;
-	t_max = d->calibrationTime;
+	t_max = TL_CONFIG(d, calibrationTime);
 
-	if ((d->enableNoisePowerMeasurement) && (t < t_max)) {
+	if ((TL_CONFIG(d, enableNoisePowerMeasurement)) && (t < t_max)) {
 		updateAvg(ch);
 	} else {
 		setState(ch, TLStruct::buttonStateReleased);
 	}
 }
 
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processStateVerifying(uint8_t ch)
+{
+	TLStruct * d;
+
+	d = &(data[ch]);
+
+	/*
+	 * The restored avg is valid if the sensor is not approached and did
+	 * not drift by more than the same threshold in the other direction.
+	 */
+	if ((d->delta < TL_CONFIG(d, releasedToApproachedThreshold)) &&
+			(d->delta > -(TL_CONFIG(d, releasedToApproachedThreshold)))) {
+		setState(ch, TLStruct::buttonStateReleased);
+	} else {
+		setState(ch, TLStruct::buttonStatePreCalibrating);
+	}
+}
+
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
 void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processStateReleased(uint8_t ch)
 {
@@ -1249,7 +2553,7 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processStateReleased(uint8
 
 	d = &(data[ch]);
 
-	if ((d->enableTouchStateMachine) && (isApproached(d))) {
+	if ((TL_CONFIG(d, enableTouchStateMachine)) && (isApproached(d))) {
 		setState(ch, TLStruct::buttonStateReleasedToApproached);
 	} else {
 		updateAvg(ch);
@@ -1265,12 +2569,12 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processStateReleasedToAppr
 
 	/* Do not update average in this state. */
 
-	if (!d->enableTouchStateMachine)
+	if (!TL_CONFIG(d, enableTouchStateMachine))
 		return;
 
 	if (isApproached(d)) {
 		if (d->lastSampledAtTime - d->stateChangedAtTime >=
-				d->releasedToApproachedTime) {
+				TL_CONFIG(d, releasedToApproachedTime)) {
 			setState(ch, TLStruct::buttonStateApproached);
 		}
 	} else {
@@ -1285,15 +2589,16 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processStateApproached(uin
 
 	d = &(data[ch]);
 
-	if (!d->enableTouchStateMachine)
+	if (!TL_CONFIG(d, enableTouchStateMachine))
 		return;
 
 	if (isReleased(d)) {
 		setState(ch, TLStruct::buttonStateApproachedToReleased);
 	} else if (isPressed(d)) {
 		setState(ch, TLStruct::buttonStateApproachedToPressed);
-	} else if ((d->approachedTimeout > 0) && (d->lastSampledAtTime - 
-			d->stateChangedAtTime > d->approachedTimeout)) {
+	} else if ((TL_CONFIG(d, approachedTimeout) > 0) &&
+			(d->lastSampledAtTime - d->stateChangedAtTime >
+			TL_CONFIG(d, approachedTimeout))) {
 		setState(ch, TLStruct::buttonStateCalibrating);
 	}
 }
@@ -1307,12 +2612,12 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processStateApproachedToPr
 
 	/* Do not update average in this state. */
 
-	if (!d->enableTouchStateMachine)
+	if (!TL_CONFIG(d, enableTouchStateMachine))
 		return;
 
 	if (isPressed(d)) {
 		if (d->lastSampledAtTime - d->stateChangedAtTime >=
-				d->approachedToPressedTime) {
+				TL_CONFIG(d, approachedToPressedTime)) {
 			setState(ch, TLStruct::buttonStatePressed);
 		}
 	} else {
@@ -1327,12 +2632,12 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processStateApproachedToRe
 
 	d = &(data[ch]);
 
-	if (!d->enableTouchStateMachine)
+	if (!TL_CONFIG(d, enableTouchStateMachine))
 		return;
 
 	if (isReleased(d)) {
 		if (d->lastSampledAtTime - d->stateChangedAtTime >=
-				d->approachedToReleasedTime) {
+				TL_CONFIG(d, approachedToReleasedTime)) {
 			setState(ch, TLStruct::buttonStateReleased);
 		}
 	} else {
@@ -1347,12 +2652,13 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processStatePressed(uint8_
 
 	d = &(data[ch]);
 
-	if (!d->enableTouchStateMachine)
+	if (!TL_CONFIG(d, enableTouchStateMachine))
 		return;
 
 	if (isPressed(d)) {
-		if ((d->pressedTimeout > 0) && (d->lastSampledAtTime - 
-				d->stateChangedAtTime > d->pressedTimeout)) {
+		if ((TL_CONFIG(d, pressedTimeout) > 0) &&
+				(d->lastSampledAtTime - d->stateChangedAtTime >
+				TL_CONFIG(d, pressedTimeout))) {
 			setState(ch, TLStruct::buttonStateCalibrating);
 		}
 	} else {
@@ -1367,14 +2673,14 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processStatePressedToAppro
 
 	d = &(data[ch]);
 
-	if (!d->enableTouchStateMachine)
+	if (!TL_CONFIG(d, enableTouchStateMachine))
 		return;
 
 	if (isPressed(d)) {
 		setState(ch, TLStruct::buttonStatePressed);
 	} else {
 		if (d->lastSampledAtTime - d->stateChangedAtTime >= 
-				d->pressedToApproachedTime) {
+				TL_CONFIG(d, pressedToApproachedTime)) {
 			setState(ch, TLStruct::buttonStateApproached);
 		}
 	}
@@ -1391,7 +2697,7 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processSample(uint8_t ch)
 		/* Do not calculate delta when avg is not yet known */
 		d->delta = 0;
 	} else {
-		if (d->direction == TLStruct::directionNegative) {
+		if (TL_CONFIG(d, direction) == TLStruct::directionNegative) {
 			d->delta = d->avg - d->value;
 		} else {
 			d->delta = d->value - d->avg;
@@ -1424,6 +2730,9 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::processSample(uint8_t ch)
 	case TLStruct::buttonStateNoisePowerMeasurement:
 		processStateNoisePowerMeasurement(ch);
 		break;
+	case TLStruct::buttonStateVerifying:
+		processStateVerifying(ch);
+		break;
 	case TLStruct::buttonStateReleased:
 		processStateReleased(ch);
 		break;
@@ -1462,6 +2771,26 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::resetButtonStateSummaries(
 	data[ch].buttonIsPressed = false;
 }
 
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::updateStateSets(uint8_t ch)
+{
+	enum TLStruct::ButtonState s;
+	bool enabled;
+
+	s = data[ch].buttonState;
+	enabled = !data[ch].disableSensor;
+
+	calibratingSensors.assign(ch, enabled &&
+		(s <= TLStruct::buttonStateVerifying));
+	releasedSensors.assign(ch, enabled &&
+		(s >= TLStruct::buttonStateReleased) &&
+		(s <= TLStruct::buttonStateReleasedToApproached));
+	approachedSensors.assign(ch, enabled &&
+		(s >= TLStruct::buttonStateApproached));
+	pressedSensors.assign(ch, enabled &&
+		(s >= TLStruct::buttonStatePressed));
+}
+
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
 int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::sample(void)
 {
@@ -1469,26 +2798,300 @@ int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::sample(void)
 }
 
 template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
-int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::sample(uint8_t nSensorsToScan)
+void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::updateButtonStateSummaries(void)
+{
+	uint8_t ch;
+
+	this->anyButtonIsApproachedVar = false;
+	this->anyButtonIsPressedVar = false;
+	for (ch = 0; ch < nSensors; ch++) {
+		resetButtonStateSummaries(ch);
+		if (data[ch].disableSensor) {
+			continue;
+		}
+		if (data[ch].buttonState <=
+				TLStruct::buttonStateVerifying) {
+			data[ch].buttonIsCalibrating = true;
+		}
+		if ((data[ch].buttonState >= TLStruct::buttonStateReleased) &&
+				(data[ch].buttonState <=
+				TLStruct::buttonStateReleasedToApproached)) {
+			data[ch].buttonIsReleased = true;
+		}
+		if (data[ch].buttonState >= TLStruct::buttonStateApproached) {
+			data[ch].buttonIsApproached = true;
+			this->anyButtonIsApproachedVar = true;
+		}
+		if (data[ch].buttonState >= TLStruct::buttonStatePressed) {
+			data[ch].buttonIsPressed = true;
+			this->anyButtonIsPressedVar = true;
+		}
+	}
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::samplePosition(uint16_t idx)
 {
-	uint16_t length, pos;
 	uint8_t ch;
 	int32_t sample1 = 0, sample2 = 0;
 	int32_t total1 = 0, total2 = 0;
-	unsigned long now;
 	enum TLStruct::WaterRejectMode w;
+	enum TLStruct::SampleType t;
+	struct TLFastPin * wp;
+	int wPin;
+	int32_t (*f)(struct TLStruct * d, uint8_t nSensors, uint8_t ch,
+		bool inv);
+	TLStruct * d;
 
-	length = ((uint16_t) nSensors) * ((uint16_t)
-		nMeasurementsPerSensor);
+	ch = getScanOrder(idx);
+
+	if (buttonMeasurementProgressCallback!= NULL) {
+		buttonMeasurementProgressCallback(idx, ch, true);
+	}
+
+	/* Read the configuration once; it may be in flash */
+	d = &(data[ch]);
+	w = TL_CONFIG(d, waterRejectMode);
+	t = TL_CONFIG(d, sampleType);
+	wPin = TL_CONFIG(d, waterRejectPin);
+	f = TL_CONFIG(d, sampleMethodSample);
+	wp = &(d->waterRejectFastPin);
+
+	if (wPin >= 0) {
+		TLFastPinUpdate(wp, wPin);
+	}
+
+	if (w == TLStruct::waterRejectModeFloat) {
+		if (wPin >= 0) {
+			/* Also disables pullup */
+			TLFastPinInput(wp);
+		}
+	} else {
+		if (wPin >= 0) {
+			TLFastPinOutput(wp);
+			if (w == TLStruct::waterRejectModeVdd) {
+				TLFastPinHigh(wp);
+			} else {
+				TLFastPinLow(wp);
+			}
+		}
+	}
+	if (t & TLStruct::sampleTypeNormal) {
+		if (f != NULL) {
+			sample1 = f(data, nSensors, ch, false);
+		}
+	}
+	if (t & TLStruct::sampleTypeInverted) {
+		if (f != NULL) {
+			sample2 = f(data, nSensors, ch, true);
+		}
+	}
+
+	/*
+	 * For sampleTypeNormal and sampleTypeInverted: scale by factor
+	 * 2 to get same amplitude as with sampleTypeDifferential.
+	 */
+	if (t == TLStruct::sampleTypeNormal) {
+		sample1 = sample1 << 1;
+	}
+	if (t == TLStruct::sampleTypeInverted) {
+		sample2 = sample2 << 1;
+	}
+
+	total1 = sample1 + sample2;
+
+	if ((w == TLStruct::waterRejectModeSum) ||
+			(w == TLStruct::waterRejectModeDiff)) {
+		if (wPin >= 0) {
+			TLFastPinOutput(wp);
+			TLFastPinHigh(wp);
+		}
+		if (t & TLStruct::sampleTypeNormal) {
+			if (f != NULL) {
+				sample1 = f(data, nSensors, ch, false);
+			}
+		}
+		if (t & TLStruct::sampleTypeInverted) {
+			if (f != NULL) {
+				sample2 = f(data, nSensors, ch, true);
+			}
+		}
+
+		/*
+		 * For sampleTypeNormal and sampleTypeInverted: scale by factor
+		 * 2 to get same amplitude as with sampleTypeDifferential.
+		 */
+		if (t == TLStruct::sampleTypeNormal) {
+			sample1 = sample1 << 1;
+		}
+		if (t == TLStruct::sampleTypeInverted) {
+			sample2 = sample2 << 1;
+		}
+		total2 = sample1 + sample2;
+	}
+
+	switch (w) {
+	case TLStruct::waterRejectModeFloat:
+		addSample(ch, total1);
+		break;
+	case TLStruct::waterRejectModeGnd:
+		addSample(ch, total1);
+		break;
+	case TLStruct::waterRejectModeVdd:
+		addSample(ch, total1);
+		break;
+	case TLStruct::waterRejectModeSum:
+		addSample(ch, total1 + total2);
+		break;
+	case TLStruct::waterRejectModeDiff:
+		addSample(ch, total1 - total2);
+		break;
+	}
+
+	if (buttonMeasurementProgressCallback!= NULL) {
+		buttonMeasurementProgressCallback(idx, ch, false);
+	}
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::sampleBackgroundPosition(uint16_t idx)
+{
+	#if defined(TL_ENABLE_BACKGROUND_SCAN)
+	enum TLStruct::SampleType t;
+	uint8_t ch;
+	int32_t sample1 = 0, sample2 = 0;
+
+	if (backgroundBuf[idx][0] == TL_BACKGROUND_POSITION_SKIPPED) {
+		/* Skip position */
+		return;
+	}
+
+	ch = getScanOrder(idx);
+
+	if (buttonMeasurementProgressCallback!= NULL) {
+		buttonMeasurementProgressCallback(idx, ch, true);
+	}
+
+	t = TL_CONFIG(&(data[ch]), sampleType);
+	if (t & TLStruct::sampleTypeNormal) {
+		sample1 = backgroundBuf[idx][0];
+	}
+	if (t & TLStruct::sampleTypeInverted) {
+		sample2 = backgroundBuf[idx][1];
+	}
+
+	/*
+	 * For sampleTypeNormal and sampleTypeInverted: scale by factor
+	 * 2 to get same amplitude as with sampleTypeDifferential.
+	 */
+	if (t == TLStruct::sampleTypeNormal) {
+		sample1 = sample1 << 1;
+	}
+	if (t == TLStruct::sampleTypeInverted) {
+		sample2 = sample2 << 1;
+	}
+
+	/* Background scans do not support water reject pins */
+	addSample(ch, sample1 + sample2);
+
+	if (buttonMeasurementProgressCallback!= NULL) {
+		buttonMeasurementProgressCallback(idx, ch, false);
+	}
+	#endif
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::startBackgroundScan(uint16_t length)
+{
+	#if defined(TL_ENABLE_BACKGROUND_SCAN)
+	uint16_t idx;
+	uint8_t ch;
+
+	/*
+	 * Select the positions to measure up front, as the foreground scan
+	 * would, and mark the others to be skipped by the background scan
+	 */
+	for (idx = 0; idx < length; idx++) {
+		if (scanAllPositions || positionIsActive(idx)) {
+			backgroundBuf[idx][0] = 0;
+		} else {
+			backgroundBuf[idx][0] = TL_BACKGROUND_POSITION_SKIPPED;
+		}
+	}
+
+	if (TLSampleMethodCVDBackgroundStart(data, nSensors, scanOrder,
+			!useCustomScanOrder, length, &(backgroundBuf[0][0])) ==
+			0) {
+		return true;
+	}
+
+	/* Let the foreground scan select the same positions again */
+	for (ch = 0; ch < nSensors; ch++) {
+		data[ch].measurementAcc = 0;
+	}
+	#endif
+
+	return false;
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::beginScan(void)
+{
+	TLBitset<N_SENSORS> mask;
+
+	mask.setAll();
+
+	return beginScan(mask);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::beginScan(uint32_t mask,
+		bool freezeSkipped)
+{
+	TLBitset<N_SENSORS> m;
+
+	/* Sensors 32 and up are not in mask and always scanned */
+	m.fromMask(mask, true);
+
+	return beginScan(m, freezeSkipped);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::beginScan(
+		const TLBitset<N_SENSORS> & mask, bool freezeSkipped)
+{
+	uint8_t ch;
+
+	if (backgroundScan) {
+		TLSampleMethodCVDBackgroundStop();
+		backgroundScan = false;
+	}
 
 	if (sequenceMeasurementProgressCallback != NULL) {
 		sequenceMeasurementProgressCallback(true);
 	}
 
+	this->freezeSkipped = freezeSkipped;
+	scanAllPositions = true;
 	for (ch = 0; ch < nSensors; ch++) {
 		data[ch].raw = 0;
+		data[ch].measurementAcc = 0;
+		data[ch].scanActive = (!data[ch].disableSensor) &&
+			mask.test(ch);
+		if (data[ch].disableSensorPrev && !data[ch].disableSensor) {
+			/* Sensor was enabled again */
+			setState(ch, TLStruct::buttonStatePreCalibrating);
+		}
+		if (data[ch].disableSensorPrev != data[ch].disableSensor) {
+			updateStateSets(ch);
+		}
+		data[ch].disableSensorPrev = data[ch].disableSensor;
+		if ((!data[ch].scanActive) || (data[ch].nMeasurementsPerSensor
+				!= nMeasurementsPerSensor)) {
+			scanAllPositions = false;
+		}
 
-		switch (data[ch].filterType) {
+		switch (TL_CONFIG(&(data[ch]), filterType)) {
 		case TLStruct::filterTypeAverage:
 			/* Nothing to do for this filter type */
 			break;
@@ -1500,170 +3103,171 @@ int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::sample(uint8_t nSensorsT
 			data[ch].filterParams.median.idx = 0;
 			break;
 		#endif
+		case TLStruct::filterTypeIIR:
+			/*
+			 * State is kept across scans; filterParams holds the
+			 * state of another filter if filterType was changed
+			 */
+			if (data[ch].filterTypePrev != TLStruct::filterTypeIIR) {
+				data[ch].filterParams.iir.primed = false;
+			}
+			break;
+		case TLStruct::filterTypeMedian3:
+			data[ch].filterParams.median3.idx = 0;
+			break;
+		case TLStruct::filterTypeTrimmedMean:
+			data[ch].filterParams.trimmedMean.idx = 0;
+			break;
 		default:
 			/* Error! */
 			break;
 		}
-			
+		data[ch].filterTypePrev = TL_CONFIG(&(data[ch]), filterType);
 	}
 
-	for (ch = 0; ch < nSensors; ch++) {
-		if (data[ch].sampleMethodPreSample != NULL) {
-			data[ch].sampleMethodPreSample(data, nSensors, ch);
-		}
-	}
-
-        for (pos = 0; pos < length; pos++) {
-                sample1 = 0;
-                sample2 = 0;
-                ch = scanOrder[pos];
-                        
-		if (buttonMeasurementProgressCallback!= NULL) {
-			buttonMeasurementProgressCallback(pos, ch, true);
-		}
-
-                w = data[ch].waterRejectMode;
-
-                if (w == TLStruct::waterRejectModeFloat) {
-                        if (data[ch].waterRejectPin >= 0) {
-                                pinMode(data[ch].waterRejectPin, INPUT);
-                                /* disable pullup */
-                                digitalWrite(data[ch].waterRejectPin, LOW);
-                        }
-                } else {
-                        if (data[ch].waterRejectPin >= 0) {
-                                pinMode(data[ch].waterRejectPin, OUTPUT);
-                                if (w == TLStruct::waterRejectModeVdd) {
-                                        digitalWrite(data[ch].waterRejectPin,
-                                                        HIGH);
-                                } else {
-                                        digitalWrite(data[ch].waterRejectPin,
-                                                        LOW);
-                                }
-                        }
-                }
-                if (data[ch].sampleType &
-                                TLStruct::sampleTypeNormal) {
-                        if (data[ch].sampleMethodSample != NULL) {
-                                sample1 = data[ch].sampleMethodSample(data,
-                                        nSensors, ch, false);
-                        }
-                }
-                if (data[ch].sampleType &
-                                TLStruct::sampleTypeInverted) {
-                        if (data[ch].sampleMethodSample != NULL) {
-                                sample2 = data[ch].sampleMethodSample(data,
-                                        nSensors, ch, true);
-                        }
-                }
-
-                /*
-                 * For sampleTypeNormal and sampleTypeInverted: scale by factor
-                 * 2 to get same amplitude as with sampleTypeDifferential.
-                 */
-                if (data[ch].sampleType == TLStruct::sampleTypeNormal) {
-                        sample1 = sample1 << 1;
-                }
-                if (data[ch].sampleType == TLStruct::sampleTypeInverted) {
-                        sample2 = sample2 << 1;
-                }
-
-                total1 = sample1 + sample2;
-
-
-
-                if ((w == TLStruct::waterRejectModeSum) ||
-                                (w == TLStruct::waterRejectModeDiff)) {
-                        if (data[ch].waterRejectPin >= 0) {
-                                pinMode(data[ch].waterRejectPin, OUTPUT);
-                                digitalWrite(data[ch].waterRejectPin, HIGH);
-                        }
-                        if (data[ch].sampleType &
-                                        TLStruct::sampleTypeNormal) {
-                                if (data[ch].sampleMethodSample != NULL) {
-                                        sample1 = data[ch].sampleMethodSample(data,
-                                                nSensors, ch, false);
-                                }
-                        }
-                        if (data[ch].sampleType &
-                                        TLStruct::sampleTypeInverted) {
-                                if (data[ch].sampleMethodSample != NULL) {
-                                        sample2 = data[ch].sampleMethodSample(data,
-                                                nSensors, ch, true);
-                                }
-                        }
-        
-                        /*
-                         * For sampleTypeNormal and sampleTypeInverted: scale by factor
-                         * 2 to get same amplitude as with sampleTypeDifferential.
-                         */
-                        if (data[ch].sampleType == TLStruct::sampleTypeNormal) {
-                                sample1 = sample1 << 1;
-                        }
-                        if (data[ch].sampleType == TLStruct::sampleTypeInverted) {
-                                sample2 = sample2 << 1;
-                        }
-                        total2 = sample1 + sample2;
-                }
-
-                switch (w) {
-                case TLStruct::waterRejectModeFloat:
-                        addSample(ch, total1);
-                        break;
-                case TLStruct::waterRejectModeGnd:
-                        addSample(ch, total1);
-                        break;
-                case TLStruct::waterRejectModeVdd:
-                        addSample(ch, total1);
-                        break;
-                case TLStruct::waterRejectModeSum:
-                        addSample(ch, total1 + total2);
-                        break;
-                case TLStruct::waterRejectModeDiff:
-                        addSample(ch, total1 - total2);
-                        break;
-                }
-
-		if (buttonMeasurementProgressCallback!= NULL) {
-			buttonMeasurementProgressCallback(pos, ch, false);
-		}
-        }
-	
-	now = millis();
+	pos = 0;
+	scanStage = scanStagePreSample;
 
-	for (ch = 0; ch < nSensors; ch++) {
-		if (data[ch].sampleMethodPostSample != NULL) {
-			data[ch].sampleMethodPostSample(data, nSensors, ch);
+	return error;
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::step(uint16_t maxPositions)
+{
+	return stepWith<RuntimeSampler>(maxPositions);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+template <class SAMPLER>
+int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::stepWith(uint16_t maxPositions)
+{
+	uint16_t length;
+	uint8_t ch;
+
+	length = ((uint16_t) nSensors) * ((uint16_t)
+		nMeasurementsPerSensor);
+
+	while ((maxPositions > 0) && (scanStage != scanStageIdle)) {
+		maxPositions--;
+
+		switch (scanStage) {
+		case scanStagePreSample:
+			ch = pos;
+			if (data[ch].scanActive) {
+				SAMPLER::preSample(this, ch);
+			}
+			if (++pos >= nSensors) {
+				pos = 0;
+				scanStage = scanStageSample;
+				backgroundScan = startBackgroundScan(length);
+			}
+			break;
+		case scanStageSample:
+			if (backgroundScan) {
+				if (pos >= TLSampleMethodCVDBackgroundProgress()) {
+					/* Not yet measured; do not wait */
+					return error;
+				}
+				sampleBackgroundPosition(pos);
+			} else if (!scanAllPositions &&
+					!positionIsActive(pos)) {
+				/* Skip position */
+			} else {
+				SAMPLER::samplePosition(this, pos);
+			}
+			if (++pos >= length) {
+				pos = 0;
+				scanStage = scanStagePostSample;
+				scanTime = millis();
+				backgroundScan = false;
+			}
+			break;
+		case scanStagePostSample:
+			ch = pos;
+			if (!data[ch].scanActive) {
+				if (freezeSkipped || data[ch].disableSensor) {
+					/* Freeze time spent in current state */
+					data[ch].stateChangedAtTime += scanTime -
+						data[ch].lastSampledAtTime;
+					data[ch].lastSampledAtTime = scanTime;
+				}
+			} else {
+				SAMPLER::postSample(this, ch);
+				processRunningMedian(ch);
+				data[ch].lastSampledAtTime = scanTime;
+				processSample(ch);
+				processAdaptiveMeasurements(ch);
+			}
+			if (++pos >= nSensors) {
+				pos = 0;
+				scanStage = scanStageSummary;
+			}
+			break;
+		case scanStageSummary:
+			updateButtonStateSummaries();
+			scanStage = scanStageIdle;
+
+			if (sequenceMeasurementProgressCallback != NULL) {
+				sequenceMeasurementProgressCallback(false);
+			}
+			break;
+		default:
+			/* Error! */
+			scanStage = scanStageIdle;
 		}
-		data[ch].lastSampledAtTime = now;
-		processSample(ch);
 	}
 
-	this->anyButtonIsApproachedVar = false;
-	this->anyButtonIsPressedVar = false;
-	for (ch = 0; ch < nSensors; ch++) {
-		resetButtonStateSummaries(ch);
-		if (data[ch].buttonState <=
-				TLStruct::buttonStateNoisePowerMeasurement) {
-			data[ch].buttonIsCalibrating = true;
-		}
-		if ((data[ch].buttonState >= TLStruct::buttonStateReleased) &&
-				(data[ch].buttonState <=
-				TLStruct::buttonStateReleasedToApproached)) {
-			data[ch].buttonIsReleased = true;
-		}
-		if (data[ch].buttonState >= TLStruct::buttonStateApproached) {
-			data[ch].buttonIsApproached = true;
-			this->anyButtonIsApproachedVar = true;
-		}
-		if (data[ch].buttonState >= TLStruct::buttonStatePressed) {
-			data[ch].buttonIsPressed = true;
-			this->anyButtonIsPressedVar = true;
-		}
+	return error;
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+bool TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::scanComplete(void)
+{
+	return (scanStage == scanStageIdle);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::sample(uint8_t nSensorsToScan)
+{
+	TLBitset<N_SENSORS> mask;
+	uint8_t ch;
+
+	mask.clearAll();
+	for (ch = 0; (ch < nSensorsToScan) && (ch < N_SENSORS); ch++) {
+		mask.set(ch);
 	}
 
-	if (sequenceMeasurementProgressCallback != NULL) {
-		sequenceMeasurementProgressCallback(false);
+	return sampleChannels(mask);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::sampleChannels(uint32_t mask,
+		bool freezeSkipped)
+{
+	TLBitset<N_SENSORS> m;
+
+	/* Sensors 32 and up are not in mask and always scanned */
+	m.fromMask(mask, true);
+
+	return sampleChannels(m, freezeSkipped);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::sampleChannels(
+		const TLBitset<N_SENSORS> & mask, bool freezeSkipped)
+{
+	return sampleChannelsWith<RuntimeSampler>(mask, freezeSkipped);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+template <class SAMPLER>
+int8_t TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::sampleChannelsWith(
+		const TLBitset<N_SENSORS> & mask, bool freezeSkipped)
+{
+	beginScan(mask, freezeSkipped);
+
+	while (!scanComplete()) {
+		stepWith<SAMPLER>(0xFFFF);
 	}
 
 	return error;
@@ -1679,7 +3283,7 @@ int TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::findSensorPair(uint8_t ch,
 
 	d = &(data[ch]);
 
-	pin = *(d->pin);
+	pin = TLConfigPin(d);
 
 	for (k = chStart; k != ch; k++) {
 		if (k >= N_SENSORS) {
@@ -1688,7 +3292,7 @@ int TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::findSensorPair(uint8_t ch,
 				break;
 			}
 		}
-		if (pin == *(data[k].pin)) {
+		if (pin == TLConfigPin(&(data[k]))) {
 			n = k;
 			break;
 		}
@@ -1725,23 +3329,24 @@ int TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::printBar(uint8_t ch_k,
 
 	if (ch_n >= 0) {
 		d_n = &(data[ch_n]);
-		tmp = d_n->sampleMethodMapDelta(data, N_SENSORS, ch_n,
+		tmp = TL_CONFIG(d_n, sampleMethodMapDelta)(data, N_SENSORS, ch_n,
 			barLength);
-		if (d_n->sampleMethod == TLSampleMethodResistive) {
+		if (TL_CONFIG(d_n, sampleMethod) == TLSampleMethodResistive) {
 			nHashes = tmp;
 		}
-		if ((d_n->sampleMethod == TLSampleMethodCVD) ||
-				(d_n->sampleMethod ==
+		if ((TL_CONFIG(d_n, sampleMethod) == TLSampleMethodCVD) ||
+				(TL_CONFIG(d_n, sampleMethod) ==
 				TLSampleMethodTouchRead)) {
 			nDashes = tmp;
 		}
 	}
-	tmp = d_k->sampleMethodMapDelta(data, N_SENSORS, ch_k, barLength);
-	if (d_k->sampleMethod == TLSampleMethodResistive) {
+	tmp = TL_CONFIG(d_k, sampleMethodMapDelta)(data, N_SENSORS, ch_k,
+		barLength);
+	if (TL_CONFIG(d_k, sampleMethod) == TLSampleMethodResistive) {
 		nHashes = tmp;
 	}
-	if ((d_k->sampleMethod == TLSampleMethodCVD) ||
-			(d_k->sampleMethod == TLSampleMethodTouchRead)) {
+	if ((TL_CONFIG(d_k, sampleMethod) == TLSampleMethodCVD) ||
+			(TL_CONFIG(d_k, sampleMethod) == TLSampleMethodTouchRead)) {
 		nDashes = tmp;
 	}
 
@@ -1777,10 +3382,391 @@ void TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::printScanOrder(void)
 
 	for (n = 0; n < ((uint16_t) nSensors) * ((uint16_t)
 			nMeasurementsPerSensor); n++) {
-		Serial.print(scanOrder[n]);
+		Serial.print(getScanOrder(n));
 		Serial.print(" ");
 	}
 	Serial.println();
 }
 
+/*
+ * TLSensorsStatic is a variant of TLSensors of which the sample method, filter
+ * type and sample type are fixed at compile time, e.g.:
+ *
+ *   TLSensorsStatic<4, 16, TLSampleMethodCVDPolicy,
+ *     TLStruct::filterTypeAverage, TLStruct::sampleTypeDifferential> s;
+ *
+ * sample(), sampleChannels() and step() run the scan loop of TLSensors with a
+ * sampler that calls the pre-sample, sample and post-sample functions of
+ * SAMPLE_METHOD directly instead of through the function pointers in data[].
+ * These are inline, and the branches on sample type, filter type and water
+ * reject mode are resolved at compile time, so the measurement, the filter and
+ * the sample correction (e.g. the scale of raw, which depends on the filter
+ * type) are inlined and constant folded into the scan loop. The TouchRead
+ * measurement itself is an exception: it stays out of line in the library.
+ *
+ * All sensors are initialized with the given sample method in the
+ * constructor; calling initialize() or changing filterType or sampleType of a
+ * sensor afterwards is not supported. Water reject pins are not supported
+ * either. A const configuration (see setConfig()) must match SAMPLE_METHOD,
+ * FILTER_TYPE and SAMPLE_TYPE. Use TLSensors for mixed setups. Scans that are
+ * started through a pointer to TLSensors (e.g. by TLScanScheduler) take the
+ * runtime path of TLSensors, which gives the same results.
+ *
+ * SAMPLE_METHOD is a struct with static functions sampleMethod(), preSample(),
+ * sample() and postSample<FILTER_TYPE>(), such as TLSampleMethodCVDPolicy,
+ * TLSampleMethodResistivePolicy and TLSampleMethodTouchReadPolicy.
+ */
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR,
+	class SAMPLE_METHOD, enum TLStruct::FilterType FILTER_TYPE,
+	enum TLStruct::SampleType SAMPLE_TYPE>
+class TLSensorsStatic : public TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>
+{
+	public:
+		TLSensorsStatic(void);
+		int8_t sample(void);
+		int8_t sample(uint8_t nSensorsToScan);
+		int8_t sampleChannels(uint32_t mask, bool freezeSkipped = true);
+		int8_t sampleChannels(const TLBitset<N_SENSORS> & mask,
+			bool freezeSkipped = true);
+		int8_t step(uint16_t maxPositions);
+
+	private:
+		struct StaticSampler {
+			static void preSample(TLSensors<N_SENSORS,
+				N_MEASUREMENTS_PER_SENSOR> * s, uint8_t ch)
+			{
+				SAMPLE_METHOD::preSample(s->data, s->nSensors,
+					ch);
+			}
+
+			static void samplePosition(TLSensors<N_SENSORS,
+				N_MEASUREMENTS_PER_SENSOR> * s, uint16_t idx)
+			{
+				static_cast<TLSensorsStatic *>(s)->
+					samplePositionStatic(idx);
+			}
+
+			static void postSample(TLSensors<N_SENSORS,
+				N_MEASUREMENTS_PER_SENSOR> * s, uint8_t ch)
+			{
+				SAMPLE_METHOD::template postSample<FILTER_TYPE>(
+					s->data, s->nSensors, ch);
+			}
+		};
+
+		void samplePositionStatic(uint16_t idx);
+};
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR,
+	class SAMPLE_METHOD, enum TLStruct::FilterType FILTER_TYPE,
+	enum TLStruct::SampleType SAMPLE_TYPE>
+TLSensorsStatic<N_SENSORS, N_MEASUREMENTS_PER_SENSOR, SAMPLE_METHOD,
+	FILTER_TYPE, SAMPLE_TYPE>::TLSensorsStatic(void)
+{
+	struct TLStructConfig * c;
+	uint8_t ch;
+
+	for (ch = 0; ch < this->nSensors; ch++) {
+		this->initialize(ch, SAMPLE_METHOD::sampleMethod());
+		c = TLConfigWritable(&(this->data[ch]));
+		if (c != NULL) {
+			c->filterType = FILTER_TYPE;
+			c->sampleType = SAMPLE_TYPE;
+			c->waterRejectPin = -1;
+		}
+	}
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR,
+	class SAMPLE_METHOD, enum TLStruct::FilterType FILTER_TYPE,
+	enum TLStruct::SampleType SAMPLE_TYPE>
+int8_t TLSensorsStatic<N_SENSORS, N_MEASUREMENTS_PER_SENSOR, SAMPLE_METHOD,
+	FILTER_TYPE, SAMPLE_TYPE>::sample(void)
+{
+	return sample(this->nSensors);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR,
+	class SAMPLE_METHOD, enum TLStruct::FilterType FILTER_TYPE,
+	enum TLStruct::SampleType SAMPLE_TYPE>
+int8_t TLSensorsStatic<N_SENSORS, N_MEASUREMENTS_PER_SENSOR, SAMPLE_METHOD,
+	FILTER_TYPE, SAMPLE_TYPE>::sample(uint8_t nSensorsToScan)
+{
+	TLBitset<N_SENSORS> mask;
+	uint8_t ch;
+
+	mask.clearAll();
+	for (ch = 0; (ch < nSensorsToScan) && (ch < N_SENSORS); ch++) {
+		mask.set(ch);
+	}
+
+	return sampleChannels(mask);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR,
+	class SAMPLE_METHOD, enum TLStruct::FilterType FILTER_TYPE,
+	enum TLStruct::SampleType SAMPLE_TYPE>
+int8_t TLSensorsStatic<N_SENSORS, N_MEASUREMENTS_PER_SENSOR, SAMPLE_METHOD,
+	FILTER_TYPE, SAMPLE_TYPE>::sampleChannels(uint32_t mask,
+	bool freezeSkipped)
+{
+	TLBitset<N_SENSORS> m;
+
+	/* Sensors 32 and up are not in mask and always scanned */
+	m.fromMask(mask, true);
+
+	return sampleChannels(m, freezeSkipped);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR,
+	class SAMPLE_METHOD, enum TLStruct::FilterType FILTER_TYPE,
+	enum TLStruct::SampleType SAMPLE_TYPE>
+int8_t TLSensorsStatic<N_SENSORS, N_MEASUREMENTS_PER_SENSOR, SAMPLE_METHOD,
+	FILTER_TYPE, SAMPLE_TYPE>::sampleChannels(
+	const TLBitset<N_SENSORS> & mask, bool freezeSkipped)
+{
+	return this->template sampleChannelsWith<StaticSampler>(mask,
+		freezeSkipped);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR,
+	class SAMPLE_METHOD, enum TLStruct::FilterType FILTER_TYPE,
+	enum TLStruct::SampleType SAMPLE_TYPE>
+int8_t TLSensorsStatic<N_SENSORS, N_MEASUREMENTS_PER_SENSOR, SAMPLE_METHOD,
+	FILTER_TYPE, SAMPLE_TYPE>::step(uint16_t maxPositions)
+{
+	return this->template stepWith<StaticSampler>(maxPositions);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR,
+	class SAMPLE_METHOD, enum TLStruct::FilterType FILTER_TYPE,
+	enum TLStruct::SampleType SAMPLE_TYPE>
+void TLSensorsStatic<N_SENSORS, N_MEASUREMENTS_PER_SENSOR, SAMPLE_METHOD,
+	FILTER_TYPE, SAMPLE_TYPE>::samplePositionStatic(uint16_t idx)
+{
+	uint8_t ch;
+	int32_t sample = 0;
+
+	ch = this->getScanOrder(idx);
+
+	if (this->buttonMeasurementProgressCallback != NULL) {
+		this->buttonMeasurementProgressCallback(idx, ch, true);
+	}
+
+	if (SAMPLE_TYPE & TLStruct::sampleTypeNormal) {
+		sample += SAMPLE_METHOD::sample(this->data, this->nSensors, ch,
+			false);
+	}
+	if (SAMPLE_TYPE & TLStruct::sampleTypeInverted) {
+		sample += SAMPLE_METHOD::sample(this->data, this->nSensors, ch,
+			true);
+	}
+
+	/*
+	 * For sampleTypeNormal and sampleTypeInverted: scale by factor 2 to get
+	 * same amplitude as with sampleTypeDifferential.
+	 */
+	if (SAMPLE_TYPE != TLStruct::sampleTypeDifferential) {
+		sample = sample << 1;
+	}
+
+	switch (FILTER_TYPE) {
+	case TLStruct::filterTypeAverage:
+		this->processFilterTypeAverage(ch, sample);
+		break;
+	case TLStruct::filterTypeSlewrateLimiter:
+		this->processFilterTypeSlewrateLimiter(ch, sample);
+		break;
+	case TLStruct::filterTypeMedian:
+		this->processFilterTypeMedian(ch, sample);
+		break;
+	case TLStruct::filterTypeIIR:
+		this->processFilterTypeIIR(ch, sample);
+		break;
+	case TLStruct::filterTypeMedian3:
+		this->processFilterTypeMedian3(ch, sample);
+		break;
+	case TLStruct::filterTypeTrimmedMean:
+		this->processFilterTypeTrimmedMean(ch, sample);
+		break;
+	}
+
+	if (this->buttonMeasurementProgressCallback != NULL) {
+		this->buttonMeasurementProgressCallback(idx, ch, false);
+	}
+}
+
+/*
+ * TLScanScheduler samples the sensors of a TLSensors object at a rate that
+ * depends on their state, e.g.:
+ *
+ *   TLSensors<8, 16> tlSensors;
+ *   TLScanScheduler<8, 16> scheduler(&tlSensors);
+ *
+ *   scheduler.stateDivider[TLStruct::buttonStateReleased] = 4;
+ *   ...
+ *   scheduler.sample(); (instead of tlSensors.sample())
+ *
+ * A sensor is measured in one of every divider scans, where divider is
+ * sensorDivider[ch] if not 0, and stateDivider[buttonState] otherwise.
+ * Sensors within neighbourDistance channels of a sensor that is approached or
+ * pressed (buttonStateReleasedToApproached or higher) are measured in every
+ * scan. Sensors with the same divider are spread over the scans, so that the
+ * scan time stays about constant.
+ *
+ * Sensors that are skipped keep their position in scanOrder and their state
+ * machine timing continues in real time: lastSampledAtTime is the time of the
+ * last scan in which a sensor was measured, and time outs and debounce times
+ * are evaluated against real time when it is measured again.
+ */
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+class TLScanScheduler
+{
+	public:
+		TLScanScheduler(TLSensors<N_SENSORS,
+			N_MEASUREMENTS_PER_SENSOR> * tlSensors);
+
+		uint8_t stateDivider[TLStruct::buttonStateMax];
+		uint8_t sensorDivider[N_SENSORS];
+		uint8_t neighbourDistance;
+
+		/*
+		 * Returns the set of sensors to measure in the next scan and
+		 * advances the schedule. Call once per scan.
+		 */
+		TLBitset<N_SENSORS> nextMask(void);
+
+		/*
+		 * Writes the positions in scanOrder that are measured with
+		 * mask (as returned by nextMask()) to list; returns the number
+		 * of positions (at most maxLength are written). This does not
+		 * take enableAdaptiveMeasurements into account.
+		 */
+		uint16_t getPositions(const TLBitset<N_SENSORS> & mask,
+			uint16_t * list, uint16_t maxLength);
+
+		int8_t sample(void);
+		int8_t beginScan(void);
+
+	private:
+		TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR> * tlSensors;
+		uint8_t countdown[N_SENSORS];
+
+		bool isActive(uint8_t ch);
+};
+
+#define TL_SCHEDULER_RELEASED_DIVIDER_DEFAULT		4
+#define TL_SCHEDULER_NEIGHBOUR_DISTANCE_DEFAULT		1
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+TLScanScheduler<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::TLScanScheduler(
+		TLSensors<N_SENSORS, N_MEASUREMENTS_PER_SENSOR> * tlSensors)
+{
+	uint8_t n;
+
+	this->tlSensors = tlSensors;
+
+	for (n = 0; n < TLStruct::buttonStateMax; n++) {
+		stateDivider[n] = 1;
+	}
+	stateDivider[TLStruct::buttonStateReleased] =
+		TL_SCHEDULER_RELEASED_DIVIDER_DEFAULT;
+
+	for (n = 0; n < N_SENSORS; n++) {
+		sensorDivider[n] = 0;
+		/* Stagger sensors so that each scan has a similar length */
+		countdown[n] = n;
+	}
+
+	neighbourDistance = TL_SCHEDULER_NEIGHBOUR_DISTANCE_DEFAULT;
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+bool TLScanScheduler<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::isActive(uint8_t ch)
+{
+	return (!tlSensors->data[ch].disableSensor) &&
+		(tlSensors->data[ch].buttonState >=
+		TLStruct::buttonStateReleasedToApproached);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+TLBitset<N_SENSORS> TLScanScheduler<N_SENSORS,
+		N_MEASUREMENTS_PER_SENSOR>::nextMask(void)
+{
+	TLBitset<N_SENSORS> mask;
+	uint8_t ch, divider;
+	int k, kMin, kMax;
+	enum TLStruct::ButtonState state;
+
+	mask.clearAll();
+	for (ch = 0; ch < tlSensors->nSensors; ch++) {
+		state = tlSensors->data[ch].buttonState;
+		if (sensorDivider[ch] > 0) {
+			divider = sensorDivider[ch];
+		} else if (state < TLStruct::buttonStateMax) {
+			divider = stateDivider[state];
+		} else {
+			divider = 1;
+		}
+
+		kMin = ((int) ch) - neighbourDistance;
+		kMax = ((int) ch) + neighbourDistance;
+		for (k = (kMin < 0) ? 0 : kMin; (divider > 1) && (k <= kMax) &&
+				(k < tlSensors->nSensors); k++) {
+			if (isActive(k)) {
+				divider = 1;
+			}
+		}
+
+		if ((divider <= 1) || (countdown[ch] % divider == 0)) {
+			mask.set(ch);
+			countdown[ch] = divider - 1;
+		} else {
+			countdown[ch]--;
+		}
+	}
+
+	return mask;
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+uint16_t TLScanScheduler<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::getPositions(
+		const TLBitset<N_SENSORS> & mask, uint16_t * list,
+		uint16_t maxLength)
+{
+	uint16_t pos, length, n = 0;
+	uint8_t ch;
+
+	length = ((uint16_t) tlSensors->nSensors) *
+		((uint16_t) tlSensors->nMeasurementsPerSensor);
+
+	for (pos = 0; pos < length; pos++) {
+		ch = tlSensors->getScanOrder(pos);
+		if (tlSensors->data[ch].disableSensor) {
+			continue;
+		}
+		if (!mask.test(ch)) {
+			continue;
+		}
+		if (n < maxLength) {
+			list[n] = pos;
+		}
+		n++;
+	}
+
+	return n;
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+int8_t TLScanScheduler<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::beginScan(void)
+{
+	return tlSensors->beginScan(nextMask(), false);
+}
+
+template <uint8_t N_SENSORS, uint8_t N_MEASUREMENTS_PER_SENSOR>
+int8_t TLScanScheduler<N_SENSORS, N_MEASUREMENTS_PER_SENSOR>::sample(void)
+{
+	return tlSensors->sampleChannels(nextMask(), false);
+}
+
 #endif